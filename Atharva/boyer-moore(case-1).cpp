@@ -4,39 +4,129 @@
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std::chrono_literals;
 using Clock = std::chrono::steady_clock;
 using TimePoint = Clock::time_point;
 
+// Inline fixed-capacity sensor code. Codes are a handful of bytes, so events
+// carry them by value and copying an event never touches the heap.
+class SensorCode {
+public:
+    static constexpr size_t kCapacity = 15;
+
+    SensorCode() = default;
+    SensorCode(const char *s) { assign(s, std::strlen(s)); }
+    SensorCode(std::string_view s) { assign(s.data(), s.size()); }
+    SensorCode(const std::string &s) { assign(s.data(), s.size()); }
+
+    // longer input is truncated to kCapacity bytes
+    void assign(const char *s, size_t n) {
+        len = (uint8_t)std::min(n, kCapacity);
+        std::memcpy(buf, s, len);
+    }
+
+    const char *data() const { return buf; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    char operator[](size_t i) const { return buf[i]; }
+    operator std::string_view() const { return std::string_view(buf, len); }
+    std::string str() const { return std::string(buf, len); }
+
+    friend std::ostream &operator<<(std::ostream &os, const SensorCode &c) {
+        return os.write(c.buf, c.len);
+    }
+
+private:
+    uint8_t len = 0;
+    char buf[kCapacity] = {};
+};
+
 struct SensorEvent {
     TimePoint ts;
-    std::string code; // short code sequence from a sensor, e.g. "HWHHD"
+    SensorCode code; // short code sequence from a sensor, e.g. "HWHHD"
     int sensorId;
+    // when the event was pushed, if that differs from ts (trace replay keeps
+    // trace time in ts); left at the epoch when ts is the push time
+    TimePoint enqueued;
+
+    TimePoint enqueueTime() const { return enqueued == TimePoint() ? ts : enqueued; }
 };
 
+// Process-wide count of operator new calls; --alloc-check reads it to show
+// that the steady-state event path does not allocate. Counting replaces the
+// global operator new with one that does an atomic add per allocation, so
+// it is only compiled in with -DBM_COUNT_ALLOCS.
+#ifdef BM_COUNT_ALLOCS
+namespace alloccount {
+inline std::atomic<uint64_t> allocations{0};
+}
+
+void *operator new(std::size_t n) {
+    alloccount::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// kept out of line so GCC does not pair the inlined free() with new-expressions
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+#endif
+
 class BoyerMoore {
 public:
-    BoyerMoore(const std::string &pattern)
+    // overlapping: after a hit, shift by the pattern's period instead of m
+    BoyerMoore(const std::string &pattern, bool overlapping = false)
         : pat(pattern), m(pattern.size()),
           badChar(256, -1), suffix(m, -1), prefix(m, false)
     {
         preprocessBadChar();
         preprocessGoodSuffix();
+        matchShift = m;
+        if (overlapping) {
+            for (int k = m - 1; k > 0; --k) {
+                if (prefix[k]) { matchShift = m - k; break; }
+            }
+        }
     }
 
     // Find all occurrences of pattern in text, return starting indices
-    std::vector<int> searchAll(const std::string &text) const {
+    std::vector<int> searchAll(std::string_view text) const {
         std::vector<int> res;
+        forEachMatch(text, [&](int i) { res.push_back(i); });
+        return res;
+    }
+
+    // number of matches searchAll would return, without building the vector
+    int countAll(std::string_view text) const {
+        int count = 0;
+        forEachMatch(text, [&](int) { ++count; });
+        return count;
+    }
+
+private:
+    std::string pat;
+    int m;
+    int matchShift;
+    std::vector<int> badChar;
+    std::vector<int> suffix;
+    std::vector<bool> prefix;
+
+    template <typename Fn>
+    void forEachMatch(std::string_view text, Fn fn) const {
         int n = (int)text.size();
-        if (m == 0 || n < m) return res;
+        if (m == 0 || n < m) return;
         int i = 0;
         while (i <= n - m) {
             int j = m - 1;
             while (j >= 0 && text[i + j] == pat[j]) --j;
             if (j < 0) {
-                res.push_back(i);
-                i += m; // move past this occurrence
+                fn(i);
+                i += matchShift; // m: move past this occurrence
             } else {
                 int bcShift = j - badChar[static_cast<unsigned char>(text[i + j])];
                 int gsShift = 0;
@@ -44,16 +134,8 @@ public:
                 i += std::max(1, std::max(bcShift, gsShift));
             }
         }
-        return res;
     }
 
-private:
-    std::string pat;
-    int m;
-    std::vector<int> badChar;
-    std::vector<int> suffix;
-    std::vector<bool> prefix;
-
     void preprocessBadChar() {
         for (int i = 0; i < 256; ++i) badChar[i] = -1;
         for (int i = 0; i < m; ++i) badChar[static_cast<unsigned char>(pat[i])] = i;
@@ -86,64 +168,694 @@ private:
     }
 };
 
+// Turbo-BM (Crochemore et al., in the Charras-Lecroq formulation): Boyer-Moore
+// plus a memory of the factor matched at the previous alignment, which is
+// skipped on the next comparison. At most 2n character comparisons, where
+// BoyerMoore degrades to O(n*m) on periodic text such as long "HHHH..." runs
+// with overlapping matches. Without overlapping, matches are those of
+// BoyerMoore::searchAll.
+class TurboBoyerMoore {
+public:
+    TurboBoyerMoore(const std::string &pattern, bool overlapping = false)
+        : pat(pattern), m((int)pattern.size()), overlapping(overlapping), bmBc(256, m), bmGs(m, m)
+    {
+        for (int i = 0; i < m - 1; ++i) bmBc[static_cast<unsigned char>(pat[i])] = m - 1 - i;
+        preprocessGoodSuffix();
+    }
+
+    std::vector<int> searchAll(std::string_view text) const {
+        std::vector<int> res;
+        forEachMatch(text, [&](int i) { res.push_back(i); });
+        return res;
+    }
+
+    int countAll(std::string_view text) const {
+        int count = 0;
+        forEachMatch(text, [&](int) { ++count; });
+        return count;
+    }
+
+private:
+    std::string pat;
+    int m;
+    bool overlapping;
+    std::vector<int> bmBc; // distance from the last occurrence to the pattern end
+    std::vector<int> bmGs; // good-suffix shift for a mismatch at i
+
+    template <typename Fn>
+    void forEachMatch(std::string_view text, Fn fn) const {
+        int n = (int)text.size();
+        if (m == 0 || n < m) return;
+        int j = 0, u = 0, shift = m; // u: length of the factor remembered from the last shift
+        while (j <= n - m) {
+            int i = m - 1;
+            while (i >= 0 && pat[i] == text[i + j]) {
+                --i;
+                if (u != 0 && i == m - 1 - shift) i -= u;
+            }
+            if (i < 0) {
+                fn(j);
+                if (overlapping) {
+                    shift = bmGs[0]; // the period
+                    u = m - shift;
+                } else {
+                    shift = m;
+                    u = 0;
+                }
+            } else {
+                int v = m - 1 - i;
+                int turboShift = u - v;
+                int bcShift = bmBc[static_cast<unsigned char>(text[i + j])] - m + 1 + i;
+                shift = std::max(std::max(turboShift, bcShift), bmGs[i]);
+                if (shift == bmGs[i]) {
+                    u = std::min(m - shift, v);
+                } else {
+                    if (turboShift < bcShift) shift = std::max(shift, u + 1);
+                    u = 0;
+                }
+            }
+            j += shift;
+        }
+    }
+
+    void preprocessGoodSuffix() {
+        if (m == 0) return; // empty pattern: never matches, nothing to shift by
+        // suff[i]: length of the longest common suffix of pat and pat[0..i]
+        std::vector<int> suff(m);
+        suff[m - 1] = m;
+        int f = 0, g = m - 1;
+        for (int i = m - 2; i >= 0; --i) {
+            if (i > g && suff[i + m - 1 - f] < i - g) {
+                suff[i] = suff[i + m - 1 - f];
+            } else {
+                if (i < g) g = i;
+                f = i;
+                while (g >= 0 && pat[g] == pat[g + m - 1 - f]) --g;
+                suff[i] = f - g;
+            }
+        }
+        for (int i = m - 1, j = 0; i >= 0; --i) {
+            if (suff[i] != i + 1) continue;
+            for (; j < m - 1 - i; ++j)
+                if (bmGs[j] == m) bmGs[j] = m - 1 - i;
+        }
+        for (int i = 0; i <= m - 2; ++i) bmGs[m - 1 - suff[i]] = m - 1 - i;
+    }
+};
+
+// Shift-Or (Baeza-Yates-Gonnet) for patterns of up to 64 bytes: the match
+// state is one machine word, updated with a shift and an OR per text byte, so
+// there are no shift-table branches at all. Match semantics are those of
+// BoyerMoore (leftmost first, non-overlapping unless asked otherwise).
+class ShiftOr {
+public:
+    static constexpr int kMaxLength = 64;
+
+    explicit ShiftOr(std::string_view pattern, bool overlapping = false)
+        : m((int)pattern.size()), overlapping(overlapping)
+    {
+        if (m > kMaxLength) throw std::length_error("ShiftOr: pattern longer than 64 bytes");
+        masks.fill(~0ULL);
+        for (int i = 0; i < m; ++i) masks[static_cast<unsigned char>(pattern[i])] &= ~(1ULL << i);
+        hit = m ? 1ULL << (m - 1) : 0;
+    }
+
+    std::vector<int> searchAll(std::string_view text) const {
+        std::vector<int> res;
+        forEachMatch(text, [&](int i) { res.push_back(i); });
+        return res;
+    }
+
+    int countAll(std::string_view text) const {
+        int count = 0;
+        forEachMatch(text, [&](int) { ++count; });
+        return count;
+    }
+
+private:
+    std::array<uint64_t, 256> masks; // bit i clear: pattern[i] is this byte
+    uint64_t hit;
+    int m;
+    bool overlapping;
+
+    // bit i of d is clear while pattern[0..i] matches the text ending here
+    template <typename Fn>
+    void forEachMatch(std::string_view text, Fn fn) const {
+        if (m == 0) return;
+        uint64_t d = ~0ULL;
+        for (int i = 0; i < (int)text.size(); ++i) {
+            d = (d << 1) | masks[static_cast<unsigned char>(text[i])];
+            if (!(d & hit)) {
+                fn(i - m + 1);
+                if (!overlapping) d = ~0ULL; // next match starts after this one
+            }
+        }
+    }
+};
+
+constexpr int constLength(const char *s) {
+    int n = 0;
+    while (s[n]) ++n;
+    return n;
+}
+
+// Boyer-Moore for a pattern fixed at build time, e.g.
+//   StaticBoyerMoore<fragments::HWHHD>::countAll(code)
+// Shift tables are computed by the compiler into static storage and the
+// right-to-left comparison is expanded for the exact pattern length. Match
+// semantics are those of BoyerMoore::searchAll; nothing allocates.
+template <const char *Pat>
+class StaticBoyerMoore {
+public:
+    static constexpr int m = constLength(Pat);
+    static_assert(m > 0, "pattern must not be empty");
+
+    static int countAll(const char *text, int n) {
+        int count = 0;
+        forEachMatch(text, n, [&](int) { ++count; });
+        return count;
+    }
+
+    static int countAll(std::string_view text) { return countAll(text.data(), (int)text.size()); }
+
+    // fn(index) for every match, left to right
+    template <typename Fn>
+    static void forEachMatch(const char *text, int n, Fn fn) {
+        int i = 0;
+        while (i <= n - m) {
+            int j = mismatchAt(text + i, std::make_index_sequence<m>{});
+            if (j < 0) {
+                fn(i);
+                i += m;
+            } else {
+                i += kTables.shift[j][static_cast<unsigned char>(text[i + j])];
+            }
+        }
+    }
+
+private:
+    // shift[j][c]: distance to move after a mismatch at j against byte c,
+    // i.e. max(1, bad-character shift, good-suffix shift)
+    struct Tables {
+        std::array<std::array<int, 256>, m> shift{};
+    };
+
+    static constexpr Tables build() {
+        std::array<int, 256> badChar{};
+        for (int c = 0; c < 256; ++c) badChar[c] = -1;
+        for (int i = 0; i < m; ++i) badChar[static_cast<unsigned char>(Pat[i])] = i;
+
+        std::array<int, m + 1> suffix{};
+        std::array<bool, m + 1> prefix{};
+        for (int i = 0; i <= m; ++i) {
+            suffix[i] = -1;
+            prefix[i] = false;
+        }
+        for (int i = 0; i < m - 1; ++i) {
+            int j = i;
+            int k = 0;
+            while (j >= 0 && Pat[j] == Pat[m - 1 - k]) {
+                --j;
+                ++k;
+                suffix[k] = j + 1;
+            }
+            if (j == -1) prefix[k] = true;
+        }
+
+        Tables t{};
+        for (int j = 0; j < m; ++j) {
+            int gs = 0;
+            if (j < m - 1) {
+                int k = m - 1 - j;
+                gs = m;
+                if (suffix[k] != -1) {
+                    gs = j - suffix[k] + 1;
+                } else {
+                    for (int r = j + 2; r <= m - 1; ++r) {
+                        if (prefix[m - r]) {
+                            gs = r;
+                            break;
+                        }
+                    }
+                }
+            }
+            for (int c = 0; c < 256; ++c) {
+                int bc = j - badChar[c];
+                int sh = bc > gs ? bc : gs;
+                t.shift[j][c] = sh > 1 ? sh : 1;
+            }
+        }
+        return t;
+    }
+
+    static constexpr Tables kTables = build();
+
+    // index of the rightmost mismatch, or -1; one comparison per pattern byte
+    template <size_t... J>
+    static int mismatchAt(const char *t, std::index_sequence<J...>) {
+        int j = -1;
+        (void)((t[m - 1 - (int)J] == Pat[m - 1 - (int)J] || ((j = m - 1 - (int)J), false)) && ...);
+        return j;
+    }
+};
+
+// Danger fragments emitted by SensorSimulator, usable as StaticBoyerMoore keys.
+namespace fragments {
+inline constexpr char HWHHD[] = "HWHHD";
+inline constexpr char LWHHB[] = "LWHHB";
+inline constexpr char HHWHD[] = "HHWHD";
+inline constexpr char HHLBD[] = "HHLBD";
+inline constexpr char HWLHD[] = "HWLHD";
+}
+
+// Multi-pattern automaton: one left-to-right pass over the text counts every
+// registered pattern. Counts follow BoyerMoore::searchAll (leftmost first,
+// non-overlapping) so both engines feed identical numbers to the trackers.
+class AhoCorasick {
+public:
+    int addPattern(const std::string &pattern) {
+        patterns.push_back(pattern);
+        return (int)patterns.size() - 1;
+    }
+
+    int patternCount() const { return (int)patterns.size(); }
+
+    void build() {
+        // alphabet compression: bytes not used by any pattern share column 0
+        classOf.fill(0);
+        sigma = 1;
+        for (auto &p : patterns)
+            for (unsigned char c : p)
+                if (classOf[c] == 0) classOf[c] = sigma++;
+
+        delta.assign(sigma, 0);
+        std::vector<std::vector<int>> own(1);
+        depth.assign(1, 0);
+        for (int id = 0; id < (int)patterns.size(); ++id) {
+            const std::string &p = patterns[id];
+            if (p.empty()) continue;
+            int s = 0;
+            for (unsigned char c : p) {
+                int a = classOf[c];
+                if (delta[s * sigma + a] == 0) {
+                    int t = (int)depth.size();
+                    delta[s * sigma + a] = t;
+                    delta.resize((size_t)(t + 1) * sigma, 0);
+                    depth.push_back(depth[s] + 1);
+                    own.emplace_back();
+                }
+                s = delta[s * sigma + a];
+            }
+            own[s].push_back(id);
+        }
+
+        // BFS turns the trie into a full transition table via failure links
+        int states = (int)depth.size();
+        std::vector<int> fail(states, 0), order;
+        order.reserve(states);
+        for (int a = 0; a < sigma; ++a) {
+            int t = delta[a];
+            if (t) order.push_back(t);
+        }
+        for (size_t h = 0; h < order.size(); ++h) {
+            int s = order[h];
+            for (int a = 0; a < sigma; ++a) {
+                int &t = delta[s * sigma + a];
+                if (t) {
+                    fail[t] = delta[fail[s] * sigma + a];
+                    order.push_back(t);
+                } else {
+                    t = delta[fail[s] * sigma + a];
+                }
+            }
+        }
+
+        // flattened output lists: own patterns followed by those of the fail state
+        outBegin.assign(states + 1, 0);
+        std::vector<std::vector<int>> outs(states);
+        for (int s : order) {
+            outs[s] = own[s];
+            outs[s].insert(outs[s].end(), outs[fail[s]].begin(), outs[fail[s]].end());
+        }
+        outIds.clear();
+        for (int s = 0; s < states; ++s) {
+            outBegin[s] = (int)outIds.size();
+            outIds.insert(outIds.end(), outs[s].begin(), outs[s].end());
+        }
+        outBegin[states] = (int)outIds.size();
+        patLen.resize(patterns.size());
+        for (size_t i = 0; i < patterns.size(); ++i) patLen[i] = (int)patterns[i].size();
+    }
+
+    // counts[id] = non-overlapping matches of pattern id; nextFree is caller-owned
+    // scratch so a steady-state scan does not allocate
+    void countAll(std::string_view text, std::vector<int> &counts, std::vector<int> &nextFree) const {
+        int P = (int)patterns.size();
+        counts.assign(P, 0);
+        nextFree.assign(P, 0);
+        int s = 0;
+        for (int i = 0; i < (int)text.size(); ++i) {
+            s = delta[s * sigma + classOf[static_cast<unsigned char>(text[i])]];
+            for (int k = outBegin[s]; k < outBegin[s + 1]; ++k) {
+                int id = outIds[k];
+                int start = i - patLen[id] + 1;
+                if (start >= nextFree[id]) {
+                    ++counts[id];
+                    nextFree[id] = i + 1;
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<std::string> patterns;
+    std::array<int, 256> classOf{};
+    int sigma = 1;
+    std::vector<int> delta;
+    std::vector<int> depth;
+    std::vector<int> outBegin;
+    std::vector<int> outIds;
+    std::vector<int> patLen;
+};
+
+// Per-sensor event-time window ("N matches in the last W ms"). Matches are
+// summed into one bucket per sensor and tick; each bucket's expiry sits on a
+// hierarchical timing wheel (4 levels x 64 slots), so a bucket is touched a
+// constant number of times however many sensors or events there are.
+class TimedWindowCounter {
+public:
+    TimedWindowCounter(std::chrono::milliseconds window, std::chrono::milliseconds resolution, int maxSensors)
+        : res(std::max(resolution, std::chrono::milliseconds(1))) {
+        windowTicks = std::max<uint64_t>(1, (uint64_t)(window / res));
+        for (auto &level : wheel) level.fill(-1);
+        reserveSensors(std::max(1, maxSensors));
+    }
+
+    // record c matches for sensorId at time ts; returns that sensor's window sum
+    int add(int sensorId, TimePoint ts, int c) {
+        advance(tickOf(ts));
+        if (sensorId < 0) return 0;
+        if (sensorId >= (int)sums.size()) reserveSensors(std::max(sensorId + 1, 2 * (int)sums.size()));
+        if (c == 0) return sums[sensorId];
+        sums[sensorId] += c;
+        allSums += c;
+        int b = openBucket[sensorId];
+        if (b >= 0 && openTick[sensorId] == now) {
+            pool[b].count += c;
+        } else {
+            b = allocBucket();
+            pool[b].sensorId = sensorId;
+            pool[b].count = c;
+            pool[b].expiry = now + windowTicks;
+            schedule(b);
+            openBucket[sensorId] = b;
+            openTick[sensorId] = now;
+        }
+        return sums[sensorId];
+    }
+
+    int count(int sensorId) const {
+        if (sensorId < 0 || sensorId >= (int)sums.size()) return 0;
+        return sums[sensorId];
+    }
+
+    // matches in the window summed over every sensor
+    int total() const { return allSums; }
+
+private:
+    static constexpr int kLevelBits = 6;
+    static constexpr int kSlots = 1 << kLevelBits;
+    static constexpr int kLevels = 4;
+
+    struct Bucket {
+        int sensorId;
+        int count;
+        uint64_t expiry; // tick at which the bucket leaves the window
+        int next;        // intrusive list link (wheel slot or free list)
+    };
+
+    std::chrono::milliseconds res;
+    uint64_t windowTicks;
+    bool started = false;
+    TimePoint epoch;
+    uint64_t now = 0;
+    size_t pending = 0;
+
+    std::array<std::array<int, kSlots>, kLevels> wheel;
+    std::vector<Bucket> pool;
+    int freeList = -1;
+
+    std::vector<int> sums;
+    int allSums = 0;
+    std::vector<int> openBucket;
+    std::vector<uint64_t> openTick;
+
+    void reserveSensors(int n) {
+        sums.resize(n, 0);
+        openBucket.resize(n, -1);
+        openTick.resize(n, 0);
+    }
+
+    uint64_t tickOf(TimePoint ts) {
+        if (!started) {
+            started = true;
+            epoch = ts;
+        }
+        if (ts <= epoch) return now;
+        uint64_t t = (uint64_t)((ts - epoch) / res);
+        return std::max(t, now); // late events count as "now"
+    }
+
+    int allocBucket() {
+        if (freeList >= 0) {
+            int b = freeList;
+            freeList = pool[b].next;
+            return b;
+        }
+        pool.push_back(Bucket{});
+        return (int)pool.size() - 1;
+    }
+
+    void schedule(int b) {
+        uint64_t expiry = pool[b].expiry;
+        uint64_t delta = expiry > now ? expiry - now : 0;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (1ull << (kLevelBits * (level + 1)))) ++level;
+        uint64_t at = std::min<uint64_t>(expiry, now + (1ull << (kLevelBits * kLevels)) - 1);
+        int slot = (int)((at >> (kLevelBits * level)) & (kSlots - 1));
+        pool[b].next = wheel[level][slot];
+        wheel[level][slot] = b;
+        ++pending;
+    }
+
+    void advance(uint64_t target) {
+        while (now < target) {
+            if (pending == 0) {
+                now = target;
+                return;
+            }
+            ++now;
+            int top = 0;
+            while (top < kLevels - 1 && (now & ((1ull << (kLevelBits * (top + 1))) - 1)) == 0) ++top;
+            for (int level = top; level >= 1; --level) {
+                int slot = (int)((now >> (kLevelBits * level)) & (kSlots - 1));
+                int b = wheel[level][slot];
+                wheel[level][slot] = -1;
+                while (b >= 0) {
+                    int next = pool[b].next;
+                    --pending;
+                    schedule(b);
+                    b = next;
+                }
+            }
+            int slot = (int)(now & (kSlots - 1));
+            int b = wheel[0][slot];
+            wheel[0][slot] = -1;
+            while (b >= 0) {
+                int next = pool[b].next;
+                --pending;
+                if (pool[b].expiry > now) schedule(b);
+                else expire(b);
+                b = next;
+            }
+        }
+    }
+
+    void expire(int b) {
+        int s = pool[b].sensorId;
+        sums[s] -= pool[b].count;
+        allSums -= pool[b].count;
+        if (openBucket[s] == b) openBucket[s] = -1;
+        pool[b].next = freeList;
+        freeList = b;
+    }
+};
+
+// Global: one window shared by every sensor (mutex protected).
+// PerSensor: one window per sensorId in a preallocated flat ring; lock-free,
+// so the tracker must be fed from a single thread (one consumer or one shard).
+// EventTime: per-sensor window measured on SensorEvent::ts via a timing wheel.
+enum class WindowMode { Global, PerSensor, EventTime };
+
+// Patterns that fit a machine word are matched with ShiftOr, longer ones with
+// BoyerMoore; both count the same non-overlapping matches.
 class PatternTracker {
 public:
-    PatternTracker(std::string p, int windowSizeEvents, int alertThreshold)
-        : pattern(std::move(p)), bm(pattern), windowSize(windowSizeEvents),
-          alertThreshold(alertThreshold), occurrences(0) { }
+    PatternTracker(std::string p, int windowSizeEvents, int alertThreshold,
+                   WindowMode mode = WindowMode::Global, int maxSensors = 0)
+        : pattern(std::move(p)), matcher(makeMatcher(pattern)), windowSize(windowSizeEvents),
+          alertThreshold(alertThreshold), mode(mode) {
+        // Global mode uses row 0 of the same flat ring, guarded by mu
+        reserveSensors(mode == WindowMode::PerSensor ? std::max(1, maxSensors) : 1);
+    }
+
+    // event-time window: alert when `threshold` matches fall within `window`
+    PatternTracker(std::string p, std::chrono::milliseconds window, int alertThreshold,
+                   int maxSensors, std::chrono::milliseconds resolution)
+        : pattern(std::move(p)), matcher(makeMatcher(pattern)), windowSize(0),
+          alertThreshold(alertThreshold), mode(WindowMode::EventTime),
+          timed(std::make_unique<TimedWindowCounter>(window, resolution, maxSensors)) { }
 
     // process incoming event code; returns true if alert should be emitted now
-    bool processEvent(const std::string &eventCode) {
-        auto matches = bm.searchAll(eventCode);
-        int count = (int)matches.size();
-        pushEventCount(count);
-        return checkAlert();
+    bool processEvent(std::string_view eventCode, int sensorId = 0, TimePoint ts = TimePoint()) {
+        int count = std::visit([&](const auto &m) { return m.countAll(eventCode); }, matcher);
+        return processCount(count, sensorId, ts);
     }
 
-    std::string name() const { return pattern; }
-
-    // current count in window
-    int currentWindowCount() const {
+    // feed a match count computed elsewhere (e.g. by a shared automaton)
+    bool processCount(int count, int sensorId = 0, TimePoint ts = TimePoint()) {
+        if (mode == WindowMode::PerSensor) return pushSensorCount(sensorId, count);
+        if (mode == WindowMode::EventTime) {
+            int sum = timed->add(sensorId, ts == TimePoint() ? Clock::now() : ts, count);
+            total.store(timed->total(), std::memory_order_relaxed);
+            return sum >= alertThreshold && alertThreshold > 0;
+        }
         std::lock_guard<std::mutex> lk(mu);
-        return occurrences;
+        return pushSensorCount(0, count);
+    }
+
+    const std::string &name() const { return pattern; }
+
+    // current count in window, summed over every sensor in PerSensor and
+    // EventTime mode; an atomic copy, so any thread may read it while the
+    // consumer is feeding the tracker
+    int currentWindowCount() const { return total.load(std::memory_order_relaxed); }
+
+    // count in the window an alert for this sensor refers to
+    int windowCount(int sensorId) const {
+        if (mode == WindowMode::Global) return currentWindowCount();
+        if (mode == WindowMode::EventTime) return timed->count(sensorId);
+        if (sensorId < 0 || sensorId >= (int)sensors.size()) return 0;
+        return sensors[sensorId].sum;
     }
 
 private:
+    struct SensorWindow {
+        int head = 0;   // next slot to overwrite
+        int filled = 0; // slots in use, up to windowSize
+        int sum = 0;
+    };
+
+    using Matcher = std::variant<ShiftOr, BoyerMoore>;
+
     std::string pattern;
-    BoyerMoore bm;
+    Matcher matcher;
     int windowSize;
     int alertThreshold;
 
     mutable std::mutex mu;
-    std::deque<int> windowCounts;
-    int occurrences;
 
-    void pushEventCount(int c) {
-        std::lock_guard<std::mutex> lk(mu);
-        windowCounts.push_back(c);
-        occurrences += c;
-        if ((int)windowCounts.size() > windowSize) {
-            occurrences -= windowCounts.front();
-            windowCounts.pop_front();
-        }
+    WindowMode mode;
+    std::vector<SensorWindow> sensors;
+    std::vector<int> ring; // sensors.size() * windowSize, row per sensor
+    std::unique_ptr<TimedWindowCounter> timed;
+    std::atomic<int> total{0}; // window count over all sensors, for other threads
+
+    static Matcher makeMatcher(const std::string &p) {
+        if ((int)p.size() <= ShiftOr::kMaxLength) return Matcher(std::in_place_type<ShiftOr>, p);
+        return Matcher(std::in_place_type<BoyerMoore>, p);
     }
 
-    bool checkAlert() const {
-        std::lock_guard<std::mutex> lk(mu);
-        return occurrences >= alertThreshold && alertThreshold > 0;
+    void reserveSensors(int n) {
+        sensors.resize(n);
+        ring.resize((size_t)n * std::max(1, windowSize), 0);
+    }
+
+    bool pushSensorCount(int sensorId, int c) {
+        if (sensorId < 0 || windowSize <= 0) return false;
+        // ids beyond the preallocated range grow the table once, then stay flat
+        if (sensorId >= (int)sensors.size()) reserveSensors(std::max(sensorId + 1, 2 * (int)sensors.size()));
+        SensorWindow &w = sensors[sensorId];
+        int &slot = ring[(size_t)sensorId * windowSize + w.head];
+        int evicted = 0;
+        if (w.filled == windowSize) evicted = slot;
+        else ++w.filled;
+        slot = c;
+        w.sum += c - evicted;
+        total.fetch_add(c - evicted, std::memory_order_relaxed);
+        if (++w.head == windowSize) w.head = 0;
+        return w.sum >= alertThreshold && alertThreshold > 0;
+    }
+};
+
+// What EventBuffer::push does when the buffer is full.
+// Block: wait for space, i.e. push back on the producer.
+// DropNewest: discard the incoming event.
+// DropOldest: evict the oldest queued event to make room.
+// Sample: keep 1 in every N incoming events (evicting the oldest), shed the rest.
+enum class OverloadPolicy { Block, DropNewest, DropOldest, Sample };
+
+struct OverloadStats {
+    uint64_t accepted = 0;
+    uint64_t blocked = 0;       // pushes that had to wait (Block)
+    uint64_t droppedNewest = 0; // incoming events discarded (DropNewest)
+    uint64_t droppedOldest = 0; // queued events evicted (DropOldest, Sample)
+    uint64_t sampledOut = 0;    // incoming events skipped by Sample
+    size_t highWater = 0;       // deepest the queue has been
+    size_t depth = 0;           // current queue length
+
+    void print(std::ostream &os, size_t capacity) const {
+        os << "buffer: accepted=" << accepted << " blocked=" << blocked
+           << " dropped_newest=" << droppedNewest << " dropped_oldest=" << droppedOldest
+           << " sampled_out=" << sampledOut << " high_water=" << highWater << "/" << capacity << "\n";
     }
 };
 
 class EventBuffer {
 public:
-    EventBuffer(size_t capacity) : cap(capacity) { }
+    EventBuffer(size_t capacity, OverloadPolicy policy = OverloadPolicy::Block, unsigned sampleEvery = 16)
+        : cap(capacity), policy(policy), sampleEvery(std::max(1u, sampleEvery)) { }
 
-    void push(SensorEvent ev) {
+    // false if the event was shed by the overload policy
+    bool push(SensorEvent ev) {
         std::unique_lock<std::mutex> lk(mu);
-        cvFull.wait(lk, [&]() { return q.size() < cap; });
+        if (q.size() >= cap) {
+            switch (policy) {
+            case OverloadPolicy::Block:
+                ++stats.blocked;
+                cvFull.wait(lk, [&]() { return q.size() < cap; });
+                break;
+            case OverloadPolicy::DropNewest:
+                ++stats.droppedNewest;
+                return false;
+            case OverloadPolicy::Sample:
+                if (++sampleTick % sampleEvery != 0) {
+                    ++stats.sampledOut;
+                    return false;
+                }
+                [[fallthrough]];
+            case OverloadPolicy::DropOldest:
+                q.pop_front();
+                ++stats.droppedOldest;
+                break;
+            }
+        }
         q.push_back(std::move(ev));
+        ++stats.accepted;
+        stats.highWater = std::max(stats.highWater, q.size());
         lk.unlock();
         cvEmpty.notify_one();
+        return true;
     }
 
     bool pop(SensorEvent &out) {
@@ -157,84 +869,903 @@ public:
         return true;
     }
 
+    // drain up to maxN events into out[] under one lock acquisition;
+    // returns 0 only once terminated and empty
+    size_t popBatch(SensorEvent *out, size_t maxN) {
+        std::unique_lock<std::mutex> lk(mu);
+        cvEmpty.wait(lk, [&]() { return !q.empty() || terminated; });
+        size_t n = std::min(maxN, q.size());
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = std::move(q.front());
+            q.pop_front();
+        }
+        lk.unlock();
+        if (n) cvFull.notify_all();
+        return n;
+    }
+
     void terminate() {
         std::lock_guard<std::mutex> lk(mu);
         terminated = true;
         cvEmpty.notify_all();
     }
 
+    OverloadStats overloadStats() const {
+        std::lock_guard<std::mutex> lk(mu);
+        OverloadStats out = stats;
+        out.depth = q.size();
+        return out;
+    }
+
+    size_t capacity() const { return cap; }
+
 private:
     std::deque<SensorEvent> q;
-    std::mutex mu;
+    mutable std::mutex mu;
     std::condition_variable cvEmpty;
     std::condition_variable cvFull;
     size_t cap;
+    OverloadPolicy policy;
+    unsigned sampleEvery;
+    uint64_t sampleTick = 0;
+    OverloadStats stats;
     bool terminated{false};
 };
 
-class AlertManager {
-public:
-    void registerPattern(const std::string &pattern, int windowEvents, int threshold) {
-        std::lock_guard<std::mutex> lk(mu);
-        trackers.emplace_back(pattern, windowEvents, threshold);
-    }
+constexpr size_t kCacheLine = 64;
 
-    void processEvent(const SensorEvent &ev) {
-        for (auto &t : trackers) {
-            bool shouldAlert = t.processEvent(ev.code);
-            if (shouldAlert) emitAlert(t.name(), ev);
-        }
-    }
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
 
-    void emitAlert(const std::string &pattern, const SensorEvent &ev) {
-        auto now = Clock::now();
-        std::time_t t = std::time(nullptr);
-        char buf[64];
-        std::snprintf(buf, sizeof(buf), "%lld", (long long)std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count());
-        std::lock_guard<std::mutex> lk(outMu);
-        std::cout << "[ALERT] pattern=" << pattern
-                  << " sensor=" << ev.sensorId
-                  << " code=" << ev.code
-                  << " time=" << buf
-                  << " window_count=" << getWindowCount(pattern)
-                  << "\n";
+inline size_t roundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+// Spin, then yield, then park on a condition variable. notify() only takes the
+// mutex when a thread is actually parked, so the uncontended path is a fence
+// and one load.
+class SpinParkWaiter {
+public:
+    template <typename Pred>
+    void wait(Pred ready) {
+        for (int i = 0; i < kSpins; ++i) {
+            if (ready()) return;
+            cpuRelax();
+        }
+        for (int i = 0; i < kYields; ++i) {
+            if (ready()) return;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lk(mu);
+        sleepers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv.wait(lk, ready);
+        sleepers.fetch_sub(1);
     }
 
-    int getWindowCount(const std::string &pattern) {
-        for (auto &t : trackers) if (t.name() == pattern) return t.currentWindowCount();
-        return 0;
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lk(mu);
+        cv.notify_all();
     }
 
 private:
-    std::vector<PatternTracker> trackers;
+    static constexpr int kSpins = 256;
+    static constexpr int kYields = 16;
+    std::atomic<int> sleepers{0};
     std::mutex mu;
-    std::mutex outMu;
+    std::condition_variable cv;
 };
 
-class SensorSimulator {
+// Bounded single-producer/single-consumer ring. Each side keeps its own index
+// and a cached copy of the other side's on a private cache line.
+template <typename T>
+class SpscRing {
 public:
-    SensorSimulator(int sensors, int eventRateMs, double dangerProb = 0.01)
-        : sensorCount(sensors), rateMs(eventRateMs), rng(std::random_device{}()),
-          dangerProbability(dangerProb) {
-        buildBasePatterns();
-    }
+    explicit SpscRing(size_t capacity)
+        : mask(roundUpPow2(std::max<size_t>(capacity, 2)) - 1), slots(mask + 1) { }
+
+    bool tryPush(T &&v) {
+        size_t t = prod.tail.load(std::memory_order_relaxed);
+        if (t - prod.headCache > mask) {
+            prod.headCache = cons.head.load(std::memory_order_acquire);
+            if (t - prod.headCache > mask) return false;
+        }
+        slots[t & mask] = std::move(v);
+        prod.tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &out) {
+        size_t h = cons.head.load(std::memory_order_relaxed);
+        if (h == cons.tailCache) {
+            cons.tailCache = prod.tail.load(std::memory_order_acquire);
+            if (h == cons.tailCache) return false;
+        }
+        out = std::move(slots[h & mask]);
+        cons.head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // racy snapshot of the fill level, good enough for load balancing
+    size_t sizeApprox() const {
+        size_t h = cons.head.load(std::memory_order_acquire);
+        size_t t = prod.tail.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct alignas(kCacheLine) ProducerSide {
+        std::atomic<size_t> tail{0};
+        size_t headCache{0};
+    };
+    struct alignas(kCacheLine) ConsumerSide {
+        std::atomic<size_t> head{0};
+        size_t tailCache{0};
+    };
+
+    const size_t mask;
+    std::vector<T> slots;
+    ProducerSide prod;
+    ConsumerSide cons;
+};
+
+// Bounded multi-producer/single-consumer ring (Vyukov sequence slots):
+// producers claim a position with one CAS, the consumer never contends.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity)
+        : mask(roundUpPow2(std::max<size_t>(capacity, 2)) - 1), slots(mask + 1) {
+        for (size_t i = 0; i <= mask; ++i) slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(T &&v) {
+        size_t pos = tail.v.load(std::memory_order_relaxed);
+        Slot *s;
+        for (;;) {
+            s = &slots[pos & mask];
+            size_t seq = s->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (tail.v.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = tail.v.load(std::memory_order_relaxed);
+            }
+        }
+        s->value = std::move(v);
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &out) {
+        size_t pos = head.v.load(std::memory_order_relaxed);
+        Slot &s = slots[pos & mask];
+        size_t seq = s.seq.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(pos + 1) < 0) return false;
+        out = std::move(s.value);
+        s.seq.store(pos + mask + 1, std::memory_order_release);
+        head.v.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        T value;
+    };
+    struct alignas(kCacheLine) PaddedIndex {
+        std::atomic<size_t> v{0};
+    };
+
+    const size_t mask;
+    std::vector<Slot> slots;
+    PaddedIndex head;
+    PaddedIndex tail;
+};
+
+// Blocking push/pop/terminate facade over a lock-free ring, interchangeable
+// with EventBuffer. Ring is SpscRing<SensorEvent> or MpscRing<SensorEvent>.
+template <typename Ring>
+class RingEventBuffer {
+public:
+    explicit RingEventBuffer(size_t capacity) : ring(capacity) { }
+
+    void push(SensorEvent ev) {
+        if (!ring.tryPush(std::move(ev))) {
+            notFull.wait([&]() { return ring.tryPush(std::move(ev)); });
+        }
+        notEmpty.notify();
+    }
+
+    bool pop(SensorEvent &out) {
+        bool got = ring.tryPop(out);
+        if (!got) {
+            notEmpty.wait([&]() {
+                got = got || ring.tryPop(out);
+                return got || terminated.load(std::memory_order_acquire);
+            });
+            if (!got) got = ring.tryPop(out);
+        }
+        if (got) notFull.notify();
+        return got;
+    }
+
+    size_t popBatch(SensorEvent *out, size_t maxN) {
+        if (maxN == 0 || !pop(out[0])) return 0;
+        size_t n = 1;
+        while (n < maxN && ring.tryPop(out[n])) ++n;
+        if (n > 1) notFull.notify();
+        return n;
+    }
+
+    void terminate() {
+        terminated.store(true, std::memory_order_release);
+        notEmpty.notify();
+    }
+
+private:
+    Ring ring;
+    SpinParkWaiter notEmpty;
+    SpinParkWaiter notFull;
+    std::atomic<bool> terminated{false};
+};
+
+// Log-linear latency histogram (HDR style): exact below 32 ns, then 32
+// sub-buckets per power of two, i.e. ~3% relative error up to 2^63 ns. Each
+// instance has a single writer thread; readers may merge it concurrently.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 5;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kBuckets = (64 - kSubBits + 1) * kSub;
+
+    LatencyHistogram() {
+        for (auto &c : counts) c.store(0, std::memory_order_relaxed);
+    }
+
+    // single-writer: plain load/store instead of a locked read-modify-write
+    void record(int64_t ns, uint64_t times = 1) {
+        uint64_t v = ns > 0 ? (uint64_t)ns : 0;
+        auto &c = counts[bucketOf(v)];
+        c.store(c.load(std::memory_order_relaxed) + times, std::memory_order_relaxed);
+        if (v > maxSeen.load(std::memory_order_relaxed)) maxSeen.store(v, std::memory_order_relaxed);
+    }
+
+    void mergeInto(std::vector<uint64_t> &into, uint64_t &maxOut) const {
+        into.resize(kBuckets, 0);
+        for (int i = 0; i < kBuckets; ++i) into[i] += counts[i].load(std::memory_order_relaxed);
+        maxOut = std::max(maxOut, maxSeen.load(std::memory_order_relaxed));
+    }
+
+    static int bucketOf(uint64_t v) {
+        if (v < (uint64_t)kSub) return (int)v;
+        int e = 63 - __builtin_clzll(v);
+        int shift = e - kSubBits;
+        return (shift + 1) * kSub + (int)((v >> shift) & (kSub - 1));
+    }
+
+    // largest value that lands in bucket i
+    static uint64_t bucketHigh(int i) {
+        if (i < kSub) return (uint64_t)i;
+        int shift = i / kSub - 1;
+        uint64_t low = (uint64_t)(kSub + i % kSub) << shift;
+        return low + ((uint64_t)1 << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> counts;
+    std::atomic<uint64_t> maxSeen{0};
+};
+
+// Event latency by pipeline stage. Every recording thread gets its own
+// histograms (registered on first use, never freed), so the hot path is a
+// couple of relaxed stores; report() merges all threads.
+class LatencyStats {
+public:
+    enum Stage { EnqueueToDequeue, DequeueToMatch, MatchToAlert, kStages };
+
+    static LatencyStats &instance() {
+        static LatencyStats stats;
+        return stats;
+    }
+
+    void record(Stage s, int64_t ns, uint64_t times = 1) {
+        if (enabled.load(std::memory_order_relaxed)) local().h[s].record(ns, times);
+    }
+
+    void setEnabled(bool on) { enabled.store(on); }
+
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t p50 = 0, p99 = 0, p999 = 0, max = 0;
+    };
+
+    Summary summarize(Stage s) const {
+        std::vector<uint64_t> merged;
+        Summary out;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            for (auto &t : threads) t->h[s].mergeInto(merged, out.max);
+        }
+        for (uint64_t c : merged) out.count += c;
+        if (out.count == 0) return out;
+        auto at = [&](double q) {
+            uint64_t rank = (uint64_t)std::ceil(q * out.count), seen = 0;
+            for (size_t i = 0; i < merged.size(); ++i) {
+                seen += merged[i];
+                if (seen >= rank) return std::min(LatencyHistogram::bucketHigh((int)i), out.max);
+            }
+            return out.max;
+        };
+        out.p50 = at(0.50);
+        out.p99 = at(0.99);
+        out.p999 = at(0.999);
+        return out;
+    }
+
+    void report(std::FILE *out) const {
+        static const char *names[kStages] = { "enqueue->dequeue", "dequeue->match", "match->alert" };
+        std::fprintf(out, "latency (us)         %12s %10s %10s %10s %10s\n", "count", "p50", "p99", "p99.9", "max");
+        for (int s = 0; s < kStages; ++s) {
+            Summary m = summarize((Stage)s);
+            std::fprintf(out, "  %-18s %12llu %10.1f %10.1f %10.1f %10.1f\n", names[s],
+                         (unsigned long long)m.count, m.p50 / 1e3, m.p99 / 1e3, m.p999 / 1e3, m.max / 1e3);
+        }
+        std::fflush(out);
+    }
+
+private:
+    struct PerThread {
+        LatencyHistogram h[kStages];
+    };
+
+    mutable std::mutex mu;
+    std::vector<std::unique_ptr<PerThread>> threads;
+    std::atomic<bool> enabled{true};
+
+    PerThread &local() {
+        thread_local PerThread *mine = nullptr;
+        if (!mine) {
+            std::lock_guard<std::mutex> lk(mu);
+            threads.push_back(std::make_unique<PerThread>());
+            mine = threads.back().get();
+        }
+        return *mine;
+    }
+};
+
+inline int64_t nanosBetween(TimePoint from, TimePoint to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+// Prints LatencyStats every periodMs until stopped (and once more on stop).
+class LatencyReporter {
+public:
+    explicit LatencyReporter(int periodMs) : period(periodMs) {
+        if (period > 0) worker = std::thread([this]() { loop(); });
+    }
+
+    ~LatencyReporter() { stop(); }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            if (stopped) return;
+            stopped = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+        LatencyStats::instance().report(stdout);
+    }
+
+private:
+    int period;
+    std::mutex mu;
+    std::condition_variable cv;
+    bool stopped = false;
+    std::thread worker;
+
+    void loop() {
+        std::unique_lock<std::mutex> lk(mu);
+        while (!cv.wait_for(lk, std::chrono::milliseconds(period), [&]() { return stopped; })) {
+            lk.unlock();
+            LatencyStats::instance().report(stdout);
+            lk.lock();
+        }
+    }
+};
+
+// Fixed-size alert as handed from a matcher thread to the alert writer.
+struct AlertRecord {
+    int64_t tsNs;        // SensorEvent::ts (steady clock)
+    int64_t matchNs;     // steady clock when the tracker fired
+    int32_t sensorId;
+    int32_t patternId;   // AlertSink pattern id, see AlertSink::registerPattern
+    int32_t windowCount;
+    uint8_t codeLen;
+    char code[11];       // event code, truncated to 11 bytes
+};
+static_assert(sizeof(AlertRecord) == 40, "AlertRecord is a fixed 40-byte log record");
+
+// Off-thread alert output. Matchers publish AlertRecords into a lock-free MPSC
+// ring and never block: when the ring is full the alert is counted as dropped.
+// A writer thread drains the ring into a line-buffered text log or a binary
+// log of raw AlertRecords. The binary log starts with "BMAL" + u32 version and
+// ends with the pattern-name table:
+//   u32 count, count x (u32 id, u16 len, bytes), u64 tableOffset, "BMAL"
+class AlertSink {
+public:
+    enum class Format { Text, Binary };
+
+    AlertSink(std::FILE *out, Format format, size_t capacity = 1 << 14, bool ownsFile = false)
+        : out(out), format(format), ownsFile(ownsFile), ring(capacity) {
+        // buffering can only be changed before first use, i.e. on files we opened
+        if (ownsFile) std::setvbuf(out, nullptr, format == Format::Text ? _IOLBF : _IOFBF, 1 << 16);
+        if (format == Format::Binary) {
+            const uint32_t version = 2;
+            std::fwrite("BMAL", 1, 4, out);
+            std::fwrite(&version, sizeof(version), 1, out);
+        }
+    }
+
+    static std::unique_ptr<AlertSink> open(const std::string &path, Format format) {
+        std::FILE *f = std::fopen(path.c_str(), format == Format::Binary ? "wb" : "w");
+        if (!f) return nullptr;
+        return std::make_unique<AlertSink>(f, format, 1 << 14, true);
+    }
+
+    ~AlertSink() {
+        stop();
+        if (ownsFile) std::fclose(out);
+    }
+
+    // stable integer id for a pattern name; the same name always maps to one id
+    int registerPattern(const std::string &name) {
+        std::lock_guard<std::mutex> lk(namesMu);
+        auto it = idByName.find(name);
+        if (it != idByName.end()) return it->second;
+        int id = (int)names.size();
+        names.push_back(name);
+        idByName.emplace(name, id);
+        return id;
+    }
+
+    void start() {
+        if (!writer.joinable()) writer = std::thread([this]() { writerLoop(); });
+    }
+
+    // drains what is queued, writes the binary trailer and joins the writer
+    void stop() {
+        if (!writer.joinable()) return;
+        stopping.store(true, std::memory_order_release);
+        ready.notify();
+        writer.join();
+        if (format == Format::Binary) writeNameTable();
+        std::fflush(out);
+    }
+
+    // hot path: never blocks
+    bool publish(AlertRecord rec) {
+        if (!ring.tryPush(std::move(rec))) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ready.notify();
+        return true;
+    }
+
+    uint64_t writtenCount() const { return written.load(); }
+    uint64_t droppedCount() const { return dropped.load(); }
+
+private:
+    std::FILE *out;
+    Format format;
+    bool ownsFile;
+    MpscRing<AlertRecord> ring;
+    SpinParkWaiter ready;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::thread writer;
+
+    std::mutex namesMu;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, int> idByName;
+    std::vector<std::string> writerNames; // writer-local copy, refreshed on miss
+
+    const std::string &nameOf(int id) {
+        if (id >= (int)writerNames.size()) {
+            std::lock_guard<std::mutex> lk(namesMu);
+            writerNames = names;
+        }
+        static const std::string unknown = "?";
+        return id >= 0 && id < (int)writerNames.size() ? writerNames[id] : unknown;
+    }
+
+    void write(const AlertRecord &r) {
+        if (format == Format::Binary) {
+            std::fwrite(&r, sizeof(r), 1, out);
+        } else {
+            std::fprintf(out, "[ALERT] pattern=%s sensor=%d code=%.*s time=%lld window_count=%d\n",
+                         nameOf(r.patternId).c_str(), r.sensorId, (int)r.codeLen, r.code,
+                         (long long)(r.tsNs / 1000000000), r.windowCount);
+        }
+        written.fetch_add(1, std::memory_order_relaxed);
+        LatencyStats::instance().record(LatencyStats::MatchToAlert,
+                                        nanosBetween(TimePoint(std::chrono::nanoseconds(r.matchNs)), Clock::now()));
+    }
+
+    void writerLoop() {
+        AlertRecord r;
+        for (;;) {
+            bool got = false;
+            ready.wait([&]() {
+                got = got || ring.tryPop(r);
+                return got || stopping.load(std::memory_order_acquire);
+            });
+            if (!got && !ring.tryPop(r)) return;
+            write(r);
+            while (ring.tryPop(r)) write(r);
+        }
+    }
+
+    void writeNameTable() {
+        std::lock_guard<std::mutex> lk(namesMu);
+        long offset = std::ftell(out);
+        uint32_t count = (uint32_t)names.size();
+        std::fwrite(&count, sizeof(count), 1, out);
+        for (uint32_t id = 0; id < count; ++id) {
+            uint16_t len = (uint16_t)std::min<size_t>(names[id].size(), 0xffff);
+            std::fwrite(&id, sizeof(id), 1, out);
+            std::fwrite(&len, sizeof(len), 1, out);
+            std::fwrite(names[id].data(), 1, len, out);
+        }
+        uint64_t off = (uint64_t)offset;
+        std::fwrite(&off, sizeof(off), 1, out);
+        std::fwrite("BMAL", 1, 4, out);
+    }
+};
+
+// Print a binary alert log written by AlertSink in the text log format.
+bool dumpAlertLog(const std::string &path, std::ostream &os) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    uint32_t version = 0;
+    if (data.size() >= 8) std::memcpy(&version, data.data() + 4, 4);
+    if (data.size() < 8 + 12 || std::memcmp(data.data(), "BMAL", 4) != 0 || version != 2 ||
+        std::memcmp(data.data() + data.size() - 4, "BMAL", 4) != 0) return false;
+    uint64_t tableOff;
+    std::memcpy(&tableOff, data.data() + data.size() - 12, 8);
+    if (tableOff < 8 || tableOff > data.size() - 12) return false;
+
+    // name table: u32 count, then count (u32 id, u16 len, bytes) entries with
+    // ids 0..count-1, ending where the trailer starts; anything else is corrupt
+    const size_t tableEnd = data.size() - 12;
+    size_t pos = tableOff;
+    if (tableEnd - pos < 4) return false;
+    uint32_t count;
+    std::memcpy(&count, data.data() + pos, 4);
+    pos += 4;
+    if (count > (tableEnd - pos) / 6) return false;
+    std::vector<std::string> names(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (tableEnd - pos < 6) return false;
+        uint32_t id;
+        uint16_t len;
+        std::memcpy(&id, data.data() + pos, 4);
+        std::memcpy(&len, data.data() + pos + 4, 2);
+        pos += 6;
+        if (id >= count || tableEnd - pos < len) return false;
+        names[id].assign(data.data() + pos, len);
+        pos += len;
+    }
+
+    for (size_t off = 8; off + sizeof(AlertRecord) <= tableOff; off += sizeof(AlertRecord)) {
+        AlertRecord r;
+        std::memcpy(&r, data.data() + off, sizeof(r));
+        os << "[ALERT] pattern=" << (r.patternId >= 0 && r.patternId < (int)names.size() ? names[r.patternId] : "?")
+           << " sensor=" << r.sensorId
+           << " code=" << std::string(r.code, std::min<size_t>(r.codeLen, sizeof(r.code)))
+           << " time=" << r.tsNs / 1000000000
+           << " window_count=" << r.windowCount
+           << "\n";
+    }
+    return true;
+}
+
+// PerPattern runs one matcher per tracker (ShiftOr or BoyerMoore); SinglePass scans each code once
+// with an Aho-Corasick automaton over all registered patterns.
+enum class MatchEngine { PerPattern, SinglePass };
+
+// Trackers are published as an immutable TrackerSet (read-copy-update):
+// registering or removing a pattern builds a new set that shares the
+// surviving trackers (and their window state), swaps it in atomically and
+// frees the old one after a grace period. The consumer side never locks.
+// processEvent/processBatch must be called by one thread at a time; the
+// register/unregister calls may come from any thread while it runs.
+class AlertManager {
+public:
+    explicit AlertManager(MatchEngine engine = MatchEngine::PerPattern) : engine(engine) {
+        current.store(new TrackerSet());
+    }
+
+    ~AlertManager() { delete current.load(); }
+
+    AlertManager(const AlertManager &) = delete;
+    AlertManager &operator=(const AlertManager &) = delete;
+
+    void registerPattern(const std::string &pattern, int windowEvents, int threshold) {
+        addTracker(std::make_shared<PatternTracker>(pattern, windowEvents, threshold));
+    }
+
+    // windows kept per sensorId; ids in [0, maxSensors) are preallocated
+    void registerPerSensorPattern(const std::string &pattern, int windowEvents, int threshold, int maxSensors) {
+        addTracker(std::make_shared<PatternTracker>(pattern, windowEvents, threshold, WindowMode::PerSensor, maxSensors));
+    }
+
+    // "threshold matches within window" per sensor, on event timestamps;
+    // resolution 0 picks window/100
+    void registerTimedPattern(const std::string &pattern, std::chrono::milliseconds window, int threshold,
+                              int maxSensors, std::chrono::milliseconds resolution = std::chrono::milliseconds(0)) {
+        if (resolution.count() <= 0) resolution = window / 100;
+        addTracker(std::make_shared<PatternTracker>(pattern, window, threshold, maxSensors, resolution));
+    }
+
+    // drops every tracker watching pattern; false if there was none
+    bool unregisterPattern(const std::string &pattern) {
+        std::lock_guard<std::mutex> lk(mu);
+        const TrackerSet &cur = *current.load();
+        auto next = std::make_unique<TrackerSet>();
+        for (auto &t : cur.trackers)
+            if (t->name() != pattern) next->trackers.push_back(t);
+        if (next->trackers.size() == cur.trackers.size()) return false;
+        publish(std::move(next));
+        return true;
+    }
+
+    // route alerts through an asynchronous sink instead of std::cout; the
+    // sink keeps pattern ids by name, so they survive re-registration
+    void attachSink(AlertSink *s) {
+        std::lock_guard<std::mutex> lk(mu);
+        sink = s;
+        auto next = std::make_unique<TrackerSet>();
+        next->trackers = current.load()->trackers;
+        publish(std::move(next));
+    }
+
+    // SensorEvent::enqueueTime() is the enqueue time; entry to processEvent /
+    // processBatch as the dequeue time
+    void processEvent(const SensorEvent &ev) {
+        auto &lat = LatencyStats::instance();
+        TimePoint dequeued = Clock::now();
+        lat.record(LatencyStats::EnqueueToDequeue, nanosBetween(ev.enqueueTime(), dequeued));
+        {
+            ReadGuard set(*this);
+            evaluateEvent(*set, ev);
+        }
+        lat.record(LatencyStats::DequeueToMatch, nanosBetween(dequeued, Clock::now()));
+    }
+
+    // tracker-major evaluation of a drained batch: each tracker's matcher and
+    // window stay hot while it walks every event
+    void processBatch(const SensorEvent *evs, size_t n) {
+        auto &lat = LatencyStats::instance();
+        TimePoint dequeued = Clock::now();
+        for (size_t e = 0; e < n; ++e) lat.record(LatencyStats::EnqueueToDequeue, nanosBetween(evs[e].enqueueTime(), dequeued));
+        {
+            ReadGuard set(*this);
+            evaluateBatch(*set, evs, n);
+        }
+        lat.record(LatencyStats::DequeueToMatch, nanosBetween(dequeued, Clock::now()), n);
+    }
+
+    // total over every sensor's window for PerSensor/EventTime trackers
+    int getWindowCount(const std::string &pattern) const {
+        ReadGuard set(*this);
+        for (auto &t : set->trackers) if (t->name() == pattern) return t->currentWindowCount();
+        return 0;
+    }
+
+    // tracker is an index in current registration order
+    int windowCountById(size_t tracker, int sensorId = 0) const {
+        ReadGuard set(*this);
+        return tracker < set->trackers.size() ? set->trackers[tracker]->windowCount(sensorId) : 0;
+    }
+
+    size_t patternCount() const {
+        ReadGuard set(*this);
+        return set->trackers.size();
+    }
+
+    uint64_t alertCount() const { return alertsEmitted.load(); }
+
+private:
+    struct TrackerSet {
+        std::vector<std::shared_ptr<PatternTracker>> trackers;
+        AhoCorasick automaton;        // SinglePass only: every tracker pattern, in order
+        AlertSink *sink = nullptr;
+        std::vector<int> patternIds;  // tracker index -> sink pattern id
+    };
+
+    struct alignas(kCacheLine) ReaderSlot {
+        std::atomic<int> active{0};
+    };
+
+    // Pins the current set. Readers count themselves into the slot of the
+    // epoch they saw; a writer waits for both slots in turn (two-phase flip)
+    // so a reader that stalled between reading the epoch and registering is
+    // still covered.
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const AlertManager &m) : slot(m.readers[m.epoch.load() & 1]) {
+            slot.active.fetch_add(1);
+            set = m.current.load();
+        }
+        ~ReadGuard() { slot.active.fetch_sub(1, std::memory_order_release); }
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+
+        const TrackerSet &operator*() const { return *set; }
+        const TrackerSet *operator->() const { return set; }
+
+    private:
+        ReaderSlot &slot;
+        const TrackerSet *set;
+    };
+
+    MatchEngine engine;
+    std::atomic<const TrackerSet *> current{nullptr};
+    mutable std::array<ReaderSlot, 2> readers;
+    std::atomic<uint64_t> epoch{0};
+    std::mutex mu;                // serialises writers
+    AlertSink *sink = nullptr;    // writer side; readers use TrackerSet::sink
+    std::vector<int> counts;      // consumer scratch
+    std::vector<int> nextFree;
+    std::vector<int> batchCounts; // event-major counts for processBatch
+    std::atomic<uint64_t> alertsEmitted{0};
+    static inline std::mutex outMu; // shared: several managers may print at once
+
+    void addTracker(std::shared_ptr<PatternTracker> t) {
+        std::lock_guard<std::mutex> lk(mu);
+        auto next = std::make_unique<TrackerSet>();
+        next->trackers = current.load()->trackers;
+        next->trackers.push_back(std::move(t));
+        publish(std::move(next));
+    }
+
+    // mu held: finish next, swap it in and reclaim the old set
+    void publish(std::unique_ptr<TrackerSet> next) {
+        next->sink = sink;
+        for (auto &t : next->trackers) {
+            if (engine == MatchEngine::SinglePass) next->automaton.addPattern(t->name());
+            if (sink) next->patternIds.push_back(sink->registerPattern(t->name()));
+        }
+        if (engine == MatchEngine::SinglePass) next->automaton.build();
+
+        const TrackerSet *old = current.exchange(next.release());
+        for (int phase = 0; phase < 2; ++phase) {
+            uint64_t e = epoch.fetch_add(1);
+            while (readers[e & 1].active.load() != 0) std::this_thread::yield();
+        }
+        delete old;
+    }
+
+    void evaluateEvent(const TrackerSet &set, const SensorEvent &ev) {
+        if (engine == MatchEngine::SinglePass) {
+            set.automaton.countAll(ev.code, counts, nextFree);
+            for (size_t i = 0; i < set.trackers.size(); ++i) {
+                auto &t = *set.trackers[i];
+                if (t.processCount(counts[i], ev.sensorId, ev.ts)) emitAlert(set, i, ev, t.windowCount(ev.sensorId));
+            }
+            return;
+        }
+        for (size_t i = 0; i < set.trackers.size(); ++i) {
+            auto &t = *set.trackers[i];
+            bool shouldAlert = t.processEvent(ev.code, ev.sensorId, ev.ts);
+            if (shouldAlert) emitAlert(set, i, ev, t.windowCount(ev.sensorId));
+        }
+    }
+
+    void evaluateBatch(const TrackerSet &set, const SensorEvent *evs, size_t n) {
+        if (engine == MatchEngine::SinglePass) {
+            size_t P = set.trackers.size();
+            batchCounts.resize(n * P);
+            for (size_t e = 0; e < n; ++e) {
+                set.automaton.countAll(evs[e].code, counts, nextFree);
+                std::copy(counts.begin(), counts.end(), batchCounts.begin() + e * P);
+            }
+            for (size_t i = 0; i < P; ++i) {
+                auto &t = *set.trackers[i];
+                for (size_t e = 0; e < n; ++e) {
+                    const SensorEvent &ev = evs[e];
+                    if (t.processCount(batchCounts[e * P + i], ev.sensorId, ev.ts))
+                        emitAlert(set, i, ev, t.windowCount(ev.sensorId));
+                }
+            }
+            return;
+        }
+        for (size_t i = 0; i < set.trackers.size(); ++i) {
+            auto &t = *set.trackers[i];
+            for (size_t e = 0; e < n; ++e) {
+                const SensorEvent &ev = evs[e];
+                if (t.processEvent(ev.code, ev.sensorId, ev.ts))
+                    emitAlert(set, i, ev, t.windowCount(ev.sensorId));
+            }
+        }
+    }
+
+    void emitAlert(const TrackerSet &set, size_t tracker, const SensorEvent &ev, int windowCount) {
+        alertsEmitted.fetch_add(1, std::memory_order_relaxed);
+        if (set.sink) {
+            AlertRecord r{};
+            r.tsNs = std::chrono::duration_cast<std::chrono::nanoseconds>(ev.ts.time_since_epoch()).count();
+            r.matchNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+            r.sensorId = ev.sensorId;
+            r.patternId = set.patternIds[tracker];
+            r.windowCount = windowCount;
+            r.codeLen = (uint8_t)std::min(ev.code.size(), sizeof(r.code));
+            std::memcpy(r.code, ev.code.data(), r.codeLen);
+            set.sink->publish(r);
+            return;
+        }
+        auto now = Clock::now();
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%lld", (long long)std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count());
+        std::lock_guard<std::mutex> lk(outMu);
+        std::cout << "[ALERT] pattern=" << set.trackers[tracker]->name()
+                  << " sensor=" << ev.sensorId
+                  << " code=" << ev.code
+                  << " time=" << buf
+                  << " window_count=" << windowCount
+                  << "\n";
+    }
+};
+
+class SensorSimulator {
+public:
+    SensorSimulator(int sensors, int eventRateMs, double dangerProb = 0.01)
+        : sensorCount(sensors), rateMs(eventRateMs), rng(std::random_device{}()),
+          dangerProbability(dangerProb) {
+        buildBasePatterns();
+    }
 
     // generate a batch of events; push into provided buffer
-    void run(EventBuffer &buffer, std::atomic<bool> &stopFlag) {
+    // (EventBuffer or any RingEventBuffer)
+    template <typename Buffer>
+    void run(Buffer &buffer, std::atomic<bool> &stopFlag) {
+        while (!stopFlag.load()) {
+            buffer.push(next());
+            if (rateMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(rateMs));
+        }
+    }
+
+    // one simulated reading, stamped now
+    SensorEvent next() {
         std::uniform_int_distribution<int> sensorDist(0, sensorCount - 1);
         std::uniform_real_distribution<double> prob(0.0, 1.0);
-        while (!stopFlag.load()) {
-            SensorEvent ev;
-            ev.ts = Clock::now();
-            ev.sensorId = sensorDist(rng);
-            if (prob(rng) < dangerProbability) {
-                ev.code = makeDangerCode();
-            } else {
-                ev.code = makeNormalCode();
-            }
-            buffer.push(std::move(ev));
-            std::this_thread::sleep_for(std::chrono::milliseconds(rateMs));
+        SensorEvent ev;
+        ev.ts = Clock::now();
+        ev.sensorId = sensorDist(rng);
+        if (prob(rng) < dangerProbability) {
+            ev.code = makeDangerCode();
+        } else {
+            ev.code = makeNormalCode();
         }
+        return ev;
     }
 
 private:
@@ -248,12 +1779,12 @@ private:
         dangerFragments = { "HWHHD", "LWHHB", "HHWHD", "HHLBD", "HWLHD" };
     }
 
-    std::string makeDangerCode() {
+    const std::string &makeDangerCode() {
         std::uniform_int_distribution<int> d(0, (int)dangerFragments.size() - 1);
         return dangerFragments[d(rng)];
     }
 
-    std::string makeNormalCode() {
+    const std::string &makeNormalCode() {
         static const std::vector<std::string> normal = {
             "LWLHB","LWLHB","LWLHB","HWHHB","HWLHB","LWHLB","LWLHD","HWLHB"
         };
@@ -262,43 +1793,794 @@ private:
     }
 };
 
-int main(int argc, char **argv) {
-    int sensorCount = 50;
-    int rateMs = 50;
-    int bufferCap = 1000;
-    int windowEvents = 40;
-    int alertThreshold = 10;
-    double dangerProb = 0.02;
+// Alert evaluation spread over worker shards. Sensors map onto a fixed set of
+// partitions; each partition owns an SPSC inbox and its own AlertManager, so
+// tracker state is never shared. A partition is drained by whichever shard
+// holds its busy flag: shards serve their home partitions first and steal
+// backlogged ones when idle. push() must be called from a single producer.
+class ShardedAlertPipeline {
+public:
+    ShardedAlertPipeline(int shards, int partitionsPerShard, size_t inboxCapacity,
+                         MatchEngine engine = MatchEngine::PerPattern)
+        : shardCount(std::max(1, shards)), stats(shardCount) {
+        int parts = shardCount * std::max(1, partitionsPerShard);
+        for (int i = 0; i < parts; ++i)
+            partitions.push_back(std::make_unique<Partition>(inboxCapacity, engine));
+    }
 
-    EventBuffer buffer(bufferCap);
-    AlertManager am;
-    am.registerPattern("HWHHD", windowEvents, alertThreshold);
-    am.registerPattern("LWHHB", windowEvents, alertThreshold);
-    am.registerPattern("HHWHD", windowEvents, alertThreshold);
+    ~ShardedAlertPipeline() {
+        terminate();
+        join();
+    }
 
-    SensorSimulator sim(sensorCount, rateMs, dangerProb);
+    void registerPattern(const std::string &pattern, int windowEvents, int threshold) {
+        for (auto &p : partitions) p->alerts.registerPattern(pattern, windowEvents, threshold);
+    }
+
+    void registerPerSensorPattern(const std::string &pattern, int windowEvents, int threshold, int maxSensors) {
+        for (auto &p : partitions) p->alerts.registerPerSensorPattern(pattern, windowEvents, threshold, maxSensors);
+    }
+
+    void registerTimedPattern(const std::string &pattern, std::chrono::milliseconds window, int threshold, int maxSensors) {
+        for (auto &p : partitions) p->alerts.registerTimedPattern(pattern, window, threshold, maxSensors);
+    }
+
+    // safe while workers run: each partition swaps in a new tracker set
+    bool unregisterPattern(const std::string &pattern) {
+        bool any = false;
+        for (auto &p : partitions) any |= p->alerts.unregisterPattern(pattern);
+        return any;
+    }
+
+    // all partitions publish into one sink; pattern ids are shared by name
+    void attachSink(AlertSink *sink) {
+        for (auto &p : partitions) p->alerts.attachSink(sink);
+    }
+
+    void start() {
+        for (int s = 0; s < shardCount; ++s) workers.emplace_back([this, s]() { workerLoop(s); });
+    }
+
+    void push(SensorEvent ev) {
+        Partition &p = *partitions[(unsigned)ev.sensorId % partitions.size()];
+        if (!p.inbox.tryPush(std::move(ev))) {
+            spaceAvailable.wait([&]() { return p.inbox.tryPush(std::move(ev)); });
+        }
+        workAvailable.notify();
+    }
+
+    // stop accepting work; workers exit once every inbox is drained
+    void terminate() {
+        terminated.store(true, std::memory_order_release);
+        workAvailable.notify();
+    }
+
+    void join() {
+        for (auto &w : workers) w.join();
+        workers.clear();
+    }
+
+    void printStats(std::ostream &os) const {
+        for (int s = 0; s < shardCount; ++s) {
+            os << "shard " << s << ": processed=" << stats[s].processed.load()
+               << " stolen=" << stats[s].stolen.load() << "\n";
+        }
+    }
+
+private:
+    static constexpr size_t kBatch = 64;
+    static constexpr size_t kStealThreshold = 32;
+
+    struct Partition {
+        Partition(size_t cap, MatchEngine engine) : inbox(cap), alerts(engine), batch(kBatch) { }
+        SpscRing<SensorEvent> inbox;
+        AlertManager alerts;
+        std::vector<SensorEvent> batch; // only touched by the busy-flag holder
+        alignas(kCacheLine) std::atomic<bool> busy{false};
+    };
+
+    struct alignas(kCacheLine) ShardStats {
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> stolen{0};
+    };
+
+    int shardCount;
+    std::vector<std::unique_ptr<Partition>> partitions;
+    std::vector<ShardStats> stats;
+    std::vector<std::thread> workers;
+    SpinParkWaiter workAvailable;
+    SpinParkWaiter spaceAvailable;
+    std::atomic<bool> terminated{false};
+
+    bool isHome(size_t p, int shard) const { return (int)(p % shardCount) == shard; }
+
+    size_t drain(Partition &p) {
+        if (p.busy.exchange(true, std::memory_order_acquire)) return 0;
+        size_t n = 0;
+        while (n < kBatch && p.inbox.tryPop(p.batch[n])) ++n;
+        if (n) p.alerts.processBatch(p.batch.data(), n);
+        p.busy.store(false, std::memory_order_release);
+        if (n) spaceAvailable.notify();
+        return n;
+    }
+
+    int pickVictim(int shard) const {
+        int victim = -1;
+        size_t best = kStealThreshold;
+        for (size_t i = 0; i < partitions.size(); ++i) {
+            if (isHome(i, shard)) continue;
+            size_t backlog = partitions[i]->inbox.sizeApprox();
+            if (backlog > best) {
+                best = backlog;
+                victim = (int)i;
+            }
+        }
+        return victim;
+    }
+
+    bool hasWork(int shard) const {
+        for (size_t i = 0; i < partitions.size(); ++i) {
+            size_t backlog = partitions[i]->inbox.sizeApprox();
+            if (isHome(i, shard) ? backlog > 0 : backlog > kStealThreshold) return true;
+        }
+        return false;
+    }
+
+    bool allEmpty() const {
+        for (auto &p : partitions)
+            if (p->inbox.sizeApprox() > 0) return false;
+        return true;
+    }
+
+    void workerLoop(int shard) {
+        for (;;) {
+            size_t done = 0;
+            for (size_t i = shard; i < partitions.size(); i += shardCount) done += drain(*partitions[i]);
+            stats[shard].processed.fetch_add(done, std::memory_order_relaxed);
+            if (done) continue;
+
+            int victim = pickVictim(shard);
+            if (victim >= 0) {
+                size_t n = drain(*partitions[victim]);
+                if (n) {
+                    stats[shard].processed.fetch_add(n, std::memory_order_relaxed);
+                    stats[shard].stolen.fetch_add(n, std::memory_order_relaxed);
+                    continue;
+                }
+            }
+
+            if (terminated.load(std::memory_order_acquire)) {
+                if (allEmpty()) return;
+                // leftovers below the steal threshold: help drain them on shutdown
+                for (auto &p : partitions)
+                    stats[shard].processed.fetch_add(drain(*p), std::memory_order_relaxed);
+                continue;
+            }
+            workAvailable.wait([&]() {
+                return hasWork(shard) || terminated.load(std::memory_order_acquire);
+            });
+        }
+    }
+};
+
+// Recorded event trace: "BMTR", u32 version, u64 count, then count fixed
+// 24-byte TraceRecords. Times are relative to the first recorded event.
+struct TraceHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+};
+
+struct TraceRecord {
+    int64_t tsNs;
+    int32_t sensorId;
+    uint8_t codeLen;
+    char code[11];
+};
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord is a fixed 24-byte record");
+
+// Buffer-compatible recorder: SensorSimulator::run (or anything with events)
+// can push straight into it. The header count is patched on close().
+class TraceWriter {
+public:
+    explicit TraceWriter(const std::string &path) : out(std::fopen(path.c_str(), "wb")) {
+        if (!out) return;
+        std::setvbuf(out, nullptr, _IOFBF, 1 << 20);
+        TraceHeader h{{'B', 'M', 'T', 'R'}, 1, 0};
+        std::fwrite(&h, sizeof(h), 1, out);
+    }
+
+    ~TraceWriter() { close(); }
+
+    bool ok() const { return out != nullptr; }
+
+    void push(const SensorEvent &ev) {
+        if (!out) return;
+        if (count == 0) first = ev.ts;
+        TraceRecord r{};
+        r.tsNs = std::chrono::duration_cast<std::chrono::nanoseconds>(ev.ts - first).count();
+        r.sensorId = ev.sensorId;
+        r.codeLen = (uint8_t)std::min(ev.code.size(), sizeof(r.code));
+        std::memcpy(r.code, ev.code.data(), r.codeLen);
+        std::fwrite(&r, sizeof(r), 1, out);
+        ++count;
+    }
+
+    void terminate() { }
+
+    void close() {
+        if (!out) return;
+        std::fseek(out, offsetof(TraceHeader, count), SEEK_SET);
+        std::fwrite(&count, sizeof(count), 1, out);
+        std::fclose(out);
+        out = nullptr;
+    }
+
+    uint64_t size() const { return count; }
+
+private:
+    std::FILE *out;
+    uint64_t count = 0;
+    TimePoint first;
+};
+
+// Read-only mmap of a trace file; records are used in place, nothing is parsed
+// up front.
+class MappedTrace {
+public:
+    explicit MappedTrace(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(TraceHeader)) {
+            void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                base = p;
+                length = st.st_size;
+                ::madvise(p, length, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        if (!base) return;
+        auto *h = static_cast<const TraceHeader *>(base);
+        size_t fits = (length - sizeof(TraceHeader)) / sizeof(TraceRecord);
+        if (std::memcmp(h->magic, "BMTR", 4) != 0 || h->version != 1 || h->count > fits) {
+            ::munmap(base, length);
+            base = nullptr;
+            return;
+        }
+        n = h->count;
+        recs = reinterpret_cast<const TraceRecord *>(static_cast<const char *>(base) + sizeof(TraceHeader));
+    }
+
+    ~MappedTrace() {
+        if (base) ::munmap(base, length);
+    }
+
+    MappedTrace(const MappedTrace &) = delete;
+    MappedTrace &operator=(const MappedTrace &) = delete;
+
+    bool ok() const { return base != nullptr; }
+    size_t size() const { return n; }
+    const TraceRecord &operator[](size_t i) const { return recs[i]; }
 
+private:
+    void *base = nullptr;
+    size_t length = 0;
+    size_t n = 0;
+    const TraceRecord *recs = nullptr;
+};
+
+// Pick the event buffer implementation by name and hand it to fn. Overload
+// policies apply to the mutex buffer; the rings always block.
+template <typename Fn>
+void withEventBuffer(const std::string &kind, size_t capacity, Fn fn,
+                     OverloadPolicy policy = OverloadPolicy::Block, unsigned sampleEvery = 16) {
+    if (kind == "spsc") {
+        RingEventBuffer<SpscRing<SensorEvent>> buffer(capacity);
+        fn(buffer);
+    } else if (kind == "mpsc") {
+        RingEventBuffer<MpscRing<SensorEvent>> buffer(capacity);
+        fn(buffer);
+    } else {
+        EventBuffer buffer(capacity, policy, sampleEvery);
+        fn(buffer);
+        buffer.overloadStats().print(std::cout, buffer.capacity());
+    }
+}
+
+// Console control while a pipeline runs: "+CODE" starts watching CODE,
+// "-CODE" stops; an empty line (or EOF) returns. Events keep flowing.
+template <typename Target, typename Add>
+void consoleLoop(Target &target, Add addPattern) {
+    std::cout << "Type +CODE / -CODE to watch / drop a pattern. Press Enter to stop.\n";
+    std::string line;
+    while (std::getline(std::cin, line) && !line.empty()) {
+        std::string code = line.substr(1);
+        if (code.empty()) continue;
+        if (line[0] == '+') {
+            addPattern(target, code);
+            std::cout << "watching " << code << "\n";
+        } else if (line[0] == '-') {
+            std::cout << (target.unregisterPattern(code) ? "dropped " : "not watched: ") << code << "\n";
+        }
+    }
+}
+
+// Interactive run: simulator -> buffer -> one consumer until Enter is pressed.
+template <typename Buffer, typename Add>
+void runPipeline(Buffer &buffer, AlertManager &am, SensorSimulator &sim, Add addPattern) {
     std::atomic<bool> stopFlag{false};
 
     std::thread producer([&]() { sim.run(buffer, stopFlag); });
 
     std::thread consumer([&]() {
-        SensorEvent ev;
-        while (buffer.pop(ev)) {
-            am.processEvent(ev);
+        std::vector<SensorEvent> batch(256);
+        size_t n;
+        while ((n = buffer.popBatch(batch.data(), batch.size())) > 0) {
+            am.processBatch(batch.data(), n);
         }
     });
 
-    std::cout << "Running simulation. Press Enter to stop.\n";
-    std::string dummy;
-    std::getline(std::cin, dummy);
+    std::cout << "Running simulation.\n";
+    consoleLoop(am, addPattern);
 
     stopFlag.store(true);
     buffer.terminate();
 
     producer.join();
     consumer.join();
+}
+
+// Interactive run with alert evaluation spread over the pipeline's shards.
+template <typename Add>
+void runSharded(ShardedAlertPipeline &pipeline, SensorSimulator &sim, Add addPattern) {
+    std::atomic<bool> stopFlag{false};
+    pipeline.start();
+    std::thread producer([&]() { sim.run(pipeline, stopFlag); });
+
+    std::cout << "Running sharded simulation.\n";
+    consoleLoop(pipeline, addPattern);
+
+    stopFlag.store(true);
+    producer.join();
+    pipeline.terminate();
+    pipeline.join();
+    pipeline.printStats(std::cout);
+}
+
+// Headless throughput check: the same pre-generated events go through an
+// EventBuffer once with pop/processEvent and once with popBatch/processBatch.
+// Alerts are disabled (unreachable threshold) so stdout does not dominate.
+template <typename Register>
+void benchBatching(int events, size_t batchSize, MatchEngine engine, Register registerPatterns) {
+    SensorSimulator sim(50, 0, 0.02);
+    std::vector<SensorEvent> input;
+    input.reserve(events);
+    for (int i = 0; i < events; ++i) input.push_back(sim.next());
+
+    auto runOnce = [&](bool batched) {
+        EventBuffer buffer(4096);
+        AlertManager am(engine);
+        registerPatterns(am);
+        auto t0 = Clock::now();
+        std::thread producer([&]() {
+            for (const auto &ev : input) buffer.push(ev);
+            buffer.terminate();
+        });
+        if (batched) {
+            std::vector<SensorEvent> batch(batchSize);
+            size_t n;
+            while ((n = buffer.popBatch(batch.data(), batch.size())) > 0) am.processBatch(batch.data(), n);
+        } else {
+            SensorEvent ev;
+            while (buffer.pop(ev)) am.processEvent(ev);
+        }
+        producer.join();
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    };
+
+    double single = runOnce(false);
+    double batched = runOnce(true);
+    std::printf("events=%d batch=%zu\n", events, batchSize);
+    std::printf("  single : %.3f s  %.0f ev/s\n", single, events / single);
+    std::printf("  batched: %.3f s  %.0f ev/s  (x%.2f)\n", batched, events / batched, single / batched);
+}
+
+// Headless replay of a recorded trace through buffer -> AlertManager.
+// speed 0 feeds as fast as possible; otherwise trace time is divided by speed
+// (1 = original pace). Events keep their trace timestamps so event-time
+// windows behave the same at any speed; the push time is stamped separately
+// so enqueue->dequeue latency is measured, not the trace schedule.
+template <typename Buffer>
+void runReplay(const MappedTrace &trace, double speed, Buffer &buffer, AlertManager &am) {
+    using Sec = std::chrono::duration<double>;
+    const TimePoint start = Clock::now();
+    double produceSec = 0, matchSec = 0;
+    uint64_t batches = 0;
+
+    std::thread producer([&]() {
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < trace.size(); ++i) {
+            const TraceRecord &r = trace[i];
+            if (speed > 0) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds((int64_t)(r.tsNs / speed)));
+            }
+            SensorEvent ev;
+            ev.ts = start + std::chrono::nanoseconds(r.tsNs);
+            ev.sensorId = r.sensorId;
+            ev.code.assign(r.code, std::min<size_t>(r.codeLen, sizeof(r.code)));
+            ev.enqueued = Clock::now();
+            buffer.push(std::move(ev));
+        }
+        buffer.terminate();
+        produceSec = Sec(Clock::now() - t0).count();
+    });
+
+    std::vector<SensorEvent> batch(256);
+    size_t n;
+    while ((n = buffer.popBatch(batch.data(), batch.size())) > 0) {
+        auto t0 = Clock::now();
+        am.processBatch(batch.data(), n);
+        matchSec += Sec(Clock::now() - t0).count();
+        ++batches;
+    }
+    producer.join();
+    double total = Sec(Clock::now() - start).count();
+
+    std::printf("replayed %zu events in %.3f s (%.0f ev/s), alerts=%llu\n",
+                trace.size(), total, trace.size() / std::max(total, 1e-9),
+                (unsigned long long)am.alertCount());
+    std::printf("  produce (decode+push): %.3f s\n", produceSec);
+    std::printf("  match (processBatch) : %.3f s over %llu batches, %.1f ns/event\n",
+                matchSec, (unsigned long long)batches, 1e9 * matchSec / std::max<size_t>(trace.size(), 1));
+    std::printf("  consumer idle/wait   : %.3f s\n", std::max(0.0, total - matchSec));
+}
+
+// Write `events` simulator readings to a trace, spaced rateMs apart in trace
+// time (generated as fast as possible rather than in real time).
+bool recordTrace(const std::string &path, int events, SensorSimulator &sim, int rateMs) {
+    TraceWriter writer(path);
+    if (!writer.ok()) return false;
+    TimePoint t = Clock::now();
+    for (int i = 0; i < events; ++i) {
+        SensorEvent ev = sim.next();
+        ev.ts = t + std::chrono::milliseconds((int64_t)i * rateMs);
+        writer.push(ev);
+    }
+    writer.close();
+    return true;
+}
+
+// Runtime BoyerMoore::searchAll vs StaticBoyerMoore::countAll over codes
+// drawn from the simulator, per code and over one long concatenated string.
+void benchStaticMatcher(int codes) {
+    using Sec = std::chrono::duration<double>;
+    SensorSimulator sim(50, 0, 0.05);
+    std::vector<std::string> input;
+    input.reserve(codes);
+    std::string joined;
+    for (int i = 0; i < codes; ++i) {
+        input.push_back(sim.next().code.str());
+        joined += input.back();
+    }
+
+    BoyerMoore runtime("HWHHD");
+    using Fixed = StaticBoyerMoore<fragments::HWHHD>;
+
+    auto t0 = Clock::now();
+    long long a = 0;
+    for (auto &c : input) a += (long long)runtime.searchAll(c).size();
+    double tRuntime = Sec(Clock::now() - t0).count();
+
+    t0 = Clock::now();
+    long long b = 0;
+    for (auto &c : input) b += Fixed::countAll(c);
+    double tStatic = Sec(Clock::now() - t0).count();
+
+    t0 = Clock::now();
+    long long la = (long long)runtime.searchAll(joined).size();
+    double tRuntimeLong = Sec(Clock::now() - t0).count();
+
+    t0 = Clock::now();
+    long long lb = Fixed::countAll(joined);
+    double tStaticLong = Sec(Clock::now() - t0).count();
+
+    std::printf("pattern HWHHD, %d codes (%zu bytes joined)\n", codes, joined.size());
+    std::printf("  per code  runtime searchAll: %6.1f ns/code  matches=%lld\n", 1e9 * tRuntime / codes, a);
+    std::printf("  per code  static countAll  : %6.1f ns/code  matches=%lld  (x%.2f)\n",
+                1e9 * tStatic / codes, b, tRuntime / tStatic);
+    std::printf("  joined    runtime searchAll: %6.2f ms  matches=%lld\n", 1e3 * tRuntimeLong, la);
+    std::printf("  joined    static countAll  : %6.2f ms  matches=%lld  (x%.2f)\n",
+                1e3 * tStaticLong, lb, tRuntimeLong / tStaticLong);
+}
+
+// BoyerMoore vs TurboBoyerMoore on periodic text of `length` bytes, the case
+// where classic Boyer-Moore rescans the same characters at every alignment.
+void benchPeriodic(int length) {
+    using Sec = std::chrono::duration<double>;
+    struct Case { const char *label; std::string unit; std::string pattern; };
+    const std::vector<Case> cases = {
+        { "H-run,  H*8",          "H",     std::string(8, 'H') },
+        { "H-run,  H*64",         "H",     std::string(64, 'H') },
+        { "H-run,  L+H*63",       "H",     "L" + std::string(63, 'H') },
+        { "HHHHL,  (HHHHL)*8",    "HHHHL", [] { std::string p; for (int i = 0; i < 8; ++i) p += "HHHHL"; return p; }() },
+        { "HHHHL,  HHHHH",        "HHHHL", "HHHHH" },
+    };
+
+    auto timeCount = [](const auto &matcher, const std::string &text, int &count) {
+        auto t0 = Clock::now();
+        count = matcher.countAll(text);
+        return Sec(Clock::now() - t0).count();
+    };
+
+    std::printf("%-20s %-8s %12s %12s %10s %8s\n", "text, pattern", "mode", "BM ms", "Turbo ms", "count", "x");
+    for (auto &c : cases) {
+        std::string text;
+        while ((int)text.size() < length) text += c.unit;
+        for (bool overlapping : { false, true }) {
+            int a = 0, b = 0;
+            double tBm = timeCount(BoyerMoore(c.pattern, overlapping), text, a);
+            double tTurbo = timeCount(TurboBoyerMoore(c.pattern, overlapping), text, b);
+            std::printf("%-20s %-8s %12.2f %12.2f %10d %8.2f%s\n", c.label, overlapping ? "overlap" : "disjoint",
+                        1e3 * tBm, 1e3 * tTurbo, b, tBm / tTurbo, a == b ? "" : "  MISMATCH");
+        }
+    }
+}
+
+// BoyerMoore::searchAll / countAll vs ShiftOr::countAll per simulator code,
+// for each danger fragment.
+void benchShiftOr(int codes) {
+    using Sec = std::chrono::duration<double>;
+    SensorSimulator sim(50, 0, 0.05);
+    std::vector<std::string> input;
+    input.reserve(codes);
+    for (int i = 0; i < codes; ++i) input.push_back(sim.next().code.str());
+
+    auto perCode = [&](auto countOne, long long &matches) {
+        matches = 0;
+        auto t0 = Clock::now();
+        for (auto &c : input) matches += countOne(c);
+        return 1e9 * Sec(Clock::now() - t0).count() / codes;
+    };
+
+    std::printf("%d simulator codes, ns/code\n", codes);
+    std::printf("%-8s %16s %16s %16s\n", "pattern", "BM searchAll", "BM countAll", "ShiftOr");
+    for (const char *pattern : { fragments::HWHHD, fragments::LWHHB, fragments::HHWHD,
+                                 fragments::HHLBD, fragments::HWLHD }) {
+        BoyerMoore bm(pattern);
+        ShiftOr so(pattern);
+        long long a, b, c;
+        double tSearch = perCode([&](const std::string &code) { return (long long)bm.searchAll(code).size(); }, a);
+        double tCount = perCode([&](const std::string &code) { return bm.countAll(code); }, b);
+        double tShiftOr = perCode([&](const std::string &code) { return so.countAll(code); }, c);
+        std::printf("%-8s %16.1f %16.1f %9.1f (x%.2f)%s\n", pattern, tSearch, tCount, tShiftOr,
+                    tSearch / tShiftOr, a == b && b == c ? "" : "  MISMATCH");
+    }
+}
+
+#ifdef BM_COUNT_ALLOCS
+// Run the simulator -> SPSC ring -> batched AlertManager -> AlertSink path
+// and count heap allocations once every buffer has reached steady state.
+void allocationCheck(int warmup, int measured, MatchEngine engine, int sensors) {
+    SensorSimulator sim(sensors, 0, 0.2);
+    RingEventBuffer<SpscRing<SensorEvent>> buffer(4096);
+    AlertSink sink(std::fopen("/dev/null", "w"), AlertSink::Format::Text, 1 << 14, true);
+    AlertManager am(engine);
+    am.registerPattern("HWHHD", 40, 3);
+    am.registerPerSensorPattern("LWHHB", 40, 2, sensors);
+    am.registerTimedPattern("HHWHD", std::chrono::milliseconds(50), 2, sensors);
+    am.attachSink(&sink);
+    sink.start();
+
+    std::atomic<uint64_t> startAllocs{0}, endAllocs{0};
+    std::thread producer([&]() {
+        for (int i = 0; i < warmup + measured; ++i) buffer.push(sim.next());
+        buffer.terminate();
+    });
+    std::thread consumer([&]() {
+        std::vector<SensorEvent> batch(256);
+        size_t n, seen = 0;
+        bool measuring = false;
+        while ((n = buffer.popBatch(batch.data(), batch.size())) > 0) {
+            am.processBatch(batch.data(), n);
+            seen += n;
+            if (!measuring && seen >= (size_t)warmup) {
+                measuring = true;
+                startAllocs = alloccount::allocations.load();
+            }
+        }
+        endAllocs = alloccount::allocations.load();
+    });
+    producer.join();
+    consumer.join();
+    sink.stop();
+
+    std::printf("alloc-check: %d warm-up + %d measured events, alerts=%llu\n",
+                warmup, measured, (unsigned long long)am.alertCount());
+    std::printf("  heap allocations during measured window: %llu\n",
+                (unsigned long long)(endAllocs - startAllocs));
+}
+#endif
+
+int main(int argc, char **argv) {
+    int sensorCount = 50;
+    int rateMs = 50;
+    int bufferCap = 1000;
+    int windowEvents = 40;
+    int alertThreshold = 10;
+    double dangerProb = 0.02;
+    MatchEngine engine = MatchEngine::PerPattern;
+    std::string bufferKind = "mutex";
+    int shards = 0; // 0 = single consumer thread
+    bool perSensor = false;
+    int timeWindowMs = 0; // > 0 switches to event-time windows
+    int benchEvents = 0;
+    bool allocCheck = false;
+    std::string alertLog;   // empty = stdout (replay: discarded)
+    std::string recordPath, replayPath;
+    int recordEvents = 100000;
+    double replaySpeed = 0;  // 0 = as fast as possible
+    AlertSink::Format alertFormat = AlertSink::Format::Text;
+    int latencyReportMs = 0; // > 0 prints latency percentiles periodically
+    OverloadPolicy overload = OverloadPolicy::Block;
+    unsigned sampleEvery = 16;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--engine" && i + 1 < argc) {
+            std::string e = argv[++i];
+            engine = (e == "single-pass" || e == "ac") ? MatchEngine::SinglePass : MatchEngine::PerPattern;
+        } else if (arg == "--buffer" && i + 1 < argc) {
+            bufferKind = argv[++i]; // mutex | spsc | mpsc
+        } else if (arg == "--shards" && i + 1 < argc) {
+            shards = std::stoi(argv[++i]);
+        } else if (arg == "--per-sensor") {
+            perSensor = true;
+        } else if (arg == "--time-window-ms" && i + 1 < argc) {
+            timeWindowMs = std::stoi(argv[++i]);
+        } else if (arg == "--bench-batch") {
+            benchEvents = (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) ? std::stoi(argv[++i]) : 1000000;
+        } else if (arg == "--bench-static") {
+            int codes = (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) ? std::stoi(argv[++i]) : 1000000;
+            benchStaticMatcher(codes);
+            return 0;
+        } else if (arg == "--bench-shift-or") {
+            int codes = (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) ? std::stoi(argv[++i]) : 1000000;
+            benchShiftOr(codes);
+            return 0;
+        } else if (arg == "--bench-periodic") {
+            int length = (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) ? std::stoi(argv[++i]) : 1 << 22;
+            benchPeriodic(length);
+            return 0;
+        } else if (arg == "--alloc-check") {
+            allocCheck = true;
+        } else if (arg == "--alert-log" && i + 1 < argc) {
+            alertLog = argv[++i];
+        } else if (arg == "--alert-format" && i + 1 < argc) {
+            alertFormat = std::string(argv[++i]) == "bin" ? AlertSink::Format::Binary : AlertSink::Format::Text;
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) recordEvents = std::stoi(argv[++i]);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--overload" && i + 1 < argc) {
+            std::string p = argv[++i]; // block | drop-newest | drop-oldest | sample[:N]
+            if (p == "drop-newest") overload = OverloadPolicy::DropNewest;
+            else if (p == "drop-oldest") overload = OverloadPolicy::DropOldest;
+            else if (p.rfind("sample", 0) == 0) {
+                overload = OverloadPolicy::Sample;
+                if (p.size() > 7 && p[6] == ':') sampleEvery = (unsigned)std::stoul(p.substr(7));
+            } else overload = OverloadPolicy::Block;
+        } else if (arg == "--latency-report-ms" && i + 1 < argc) {
+            latencyReportMs = std::stoi(argv[++i]);
+        } else if (arg == "--speed" && i + 1 < argc) {
+            replaySpeed = std::stod(argv[++i]);
+        } else if (arg == "--dump-alerts" && i + 1 < argc) {
+            if (!dumpAlertLog(argv[++i], std::cout)) {
+                std::cerr << "Not a binary alert log: " << argv[i] << "\n";
+                return 1;
+            }
+            return 0;
+        }
+    }
+
+    // only the mutex EventBuffer implements overload policies; the rings and
+    // the shard inboxes always block the producer when full
+    if (overload != OverloadPolicy::Block && (shards > 0 || bufferKind == "spsc" || bufferKind == "mpsc")) {
+        std::cerr << "--overload needs --buffer mutex without --shards (rings and shard inboxes always block)\n";
+        return 1;
+    }
+
+    const std::vector<std::string> watched = { "HWHHD", "LWHHB", "HHWHD" };
+    auto registerOne = [&](auto &target, const std::string &p) {
+        if (timeWindowMs > 0)
+            target.registerTimedPattern(p, std::chrono::milliseconds(timeWindowMs), alertThreshold, sensorCount);
+        else if (perSensor) target.registerPerSensorPattern(p, windowEvents, alertThreshold, sensorCount);
+        else target.registerPattern(p, windowEvents, alertThreshold);
+    };
+    auto registerDefaults = [&](auto &target) {
+        for (auto &p : watched) registerOne(target, p);
+    };
+
+    if (allocCheck) {
+#ifdef BM_COUNT_ALLOCS
+        allocationCheck(100000, 1000000, engine, sensorCount);
+        return 0;
+#else
+        std::cerr << "--alloc-check needs a build with -DBM_COUNT_ALLOCS\n";
+        return 1;
+#endif
+    }
+
+    if (benchEvents > 0) {
+        benchBatching(benchEvents, 256, engine, [&](AlertManager &am) {
+            for (auto &p : watched) am.registerPattern(p, windowEvents, std::numeric_limits<int>::max());
+        });
+        return 0;
+    }
+
+    SensorSimulator sim(sensorCount, rateMs, dangerProb);
+
+    if (!recordPath.empty()) {
+        if (!recordTrace(recordPath, recordEvents, sim, rateMs)) {
+            std::cerr << "Cannot write trace " << recordPath << "\n";
+            return 1;
+        }
+        std::cout << "Recorded " << recordEvents << " events to " << recordPath << "\n";
+        return 0;
+    }
+
+    if (!replayPath.empty() && alertLog.empty()) alertLog = "/dev/null";
+
+    std::unique_ptr<AlertSink> sink;
+    if (alertLog.empty()) {
+        sink = std::make_unique<AlertSink>(stdout, AlertSink::Format::Text);
+    } else {
+        sink = AlertSink::open(alertLog, alertFormat);
+        if (!sink) {
+            std::cerr << "Cannot open alert log " << alertLog << "\n";
+            return 1;
+        }
+    }
+    sink->start();
+    LatencyReporter latency(latencyReportMs); // final report once the sink has drained
+
+    if (shards > 0) {
+        ShardedAlertPipeline pipeline(shards, 4, bufferCap, engine);
+        registerDefaults(pipeline);
+        pipeline.attachSink(sink.get());
+        runSharded(pipeline, sim, registerOne);
+        sink->stop();
+        latency.stop();
+        std::cout << "Stopped. alerts written=" << sink->writtenCount() << " dropped=" << sink->droppedCount() << "\n";
+        return 0;
+    }
+
+    AlertManager am(engine);
+    registerDefaults(am);
+    am.attachSink(sink.get());
+
+    if (!replayPath.empty()) {
+        MappedTrace trace(replayPath);
+        if (!trace.ok()) {
+            std::cerr << "Not a readable trace: " << replayPath << "\n";
+            return 1;
+        }
+        withEventBuffer(bufferKind, bufferCap, [&](auto &buffer) { runReplay(trace, replaySpeed, buffer, am); },
+                        overload, sampleEvery);
+        sink->stop();
+        latency.stop();
+        std::printf("  alerts written=%llu dropped=%llu\n",
+                    (unsigned long long)sink->writtenCount(), (unsigned long long)sink->droppedCount());
+        return 0;
+    }
+
+    withEventBuffer(bufferKind, bufferCap, [&](auto &buffer) { runPipeline(buffer, am, sim, registerOne); },
+                    overload, sampleEvery);
 
-    std::cout << "Stopped.\n";
+    sink->stop();
+    latency.stop();
+    std::cout << "Stopped. alerts written=" << sink->writtenCount() << " dropped=" << sink->droppedCount() << "\n";
     return 0;
 }
@@ -1,104 +1,1186 @@
 #include <bits/stdc++.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 using namespace std;
 
-// A Trie node representing one character in a skill word.
+// A Trie node representing one character in a skill word. Nodes live in
+// SkillTrie's pool and refer to each other by index; index 0 is the root, so
+// it doubles as "no child".
 struct SkillNode {
-    array<SkillNode*, 26> next;
+    array<uint32_t, 26> next;
+    bool isEnd;
+    int wordCount;  // (skill, profile) links at or below this node
+    int skillCount; // distinct skills at or below this node
+    uint32_t postings; // slot in SkillTrie::postings, valid when isEnd
+
+    SkillNode() : isEnd(false), wordCount(0), skillCount(0), postings(0) {
+        next.fill(0);
+    }
+};
+
+// The original pointer-per-child node, kept only to size the old layout in
+// memory reports.
+struct PointerSkillNode {
+    array<void*, 26> next;
     bool isEnd;
     int wordCount;
     vector<int> linkedProfiles;
+};
+
+// Sorted set of profile ids. Up to kSmallMax ids are one sorted array; larger
+// sets go Roaring style: ids are grouped by their high 16 bits into
+// containers, and a container keeps its low halves as a sorted uint16 array
+// while it has at most kArrayMax of them, as a 65536-bit bitmap beyond that.
+// Ids must be non-negative.
+class PostingList {
+public:
+    static constexpr uint32_t kSmallMax = 512;
+    static constexpr uint32_t kArrayMax = 4096;
+
+    // false if id was already present
+    bool add(int id) {
+        if (containers.empty()) {
+            uint32_t v = (uint32_t)id;
+            auto it = (small.empty() || small.back() < v) ? small.end() : lower_bound(small.begin(), small.end(), v);
+            if (it != small.end() && *it == v) return false;
+            small.insert(it, v);
+            if (small.size() > kSmallMax) promote();
+            return true;
+        }
+        return addToContainer(id);
+    }
+
+    bool contains(int id) const {
+        if (containers.empty()) return binary_search(small.begin(), small.end(), (uint32_t)id);
+        uint16_t hi = (uint32_t)id >> 16;
+        auto it = lower_bound(containers.begin(), containers.end(), hi,
+                              [](const Container &c, uint16_t k) { return c.key < k; });
+        return it != containers.end() && it->key == hi && it->contains((uint32_t)id & 0xFFFF);
+    }
+
+    size_t size() const {
+        size_t n = small.size();
+        for (auto &c : containers) n += c.card;
+        return n;
+    }
+
+    bool empty() const { return small.empty() && containers.empty(); }
+
+    // ids in ascending order
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        forEachWhile([&](int id) {
+            fn(id);
+            return true;
+        });
+    }
+
+    // ids in ascending order until fn returns false; false if it did
+    template <typename Fn>
+    bool forEachWhile(Fn fn) const {
+        for (uint32_t v : small)
+            if (!fn((int)v)) return false;
+        for (auto &c : containers) {
+            int base = (int)c.key << 16;
+            if (c.bitmap.empty()) {
+                for (uint16_t lo : c.array)
+                    if (!fn(base | lo)) return false;
+                continue;
+            }
+            for (int w = 0; w < 1024; w++)
+                for (uint64_t bits = c.bitmap[w]; bits; bits &= bits - 1)
+                    if (!fn(base | (w << 6 | __builtin_ctzll(bits)))) return false;
+        }
+        return true;
+    }
+
+    vector<int> toVector() const {
+        vector<int> out;
+        out.reserve(size());
+        forEach([&](int id) { out.push_back(id); });
+        return out;
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = small.capacity() * sizeof(uint32_t) + containers.capacity() * sizeof(Container);
+        for (auto &c : containers) bytes += c.array.capacity() * sizeof(uint16_t) + c.bitmap.capacity() * sizeof(uint64_t);
+        return bytes;
+    }
+
+    static PostingList intersect(const PostingList &a, const PostingList &b) {
+        return combine(a, b, Op::And);
+    }
+
+    static PostingList unite(const PostingList &a, const PostingList &b) {
+        return combine(a, b, Op::Or);
+    }
+
+    // a AND NOT b
+    static PostingList subtract(const PostingList &a, const PostingList &b) {
+        return combine(a, b, Op::AndNot);
+    }
+
+private:
+    enum class Op { And, Or, AndNot };
+
+    struct Container;
+
+    vector<uint32_t> small;       // the whole set while it has <= kSmallMax ids
+    vector<Container> containers; // otherwise; sorted by key
+
+    bool addToContainer(int id) {
+        uint16_t hi = (uint32_t)id >> 16, lo = (uint32_t)id & 0xFFFF;
+        if (containers.empty() || containers.back().key < hi) {
+            containers.emplace_back();
+            containers.back().key = hi;
+            return containers.back().add(lo);
+        }
+        auto it = lower_bound(containers.begin(), containers.end(), hi,
+                              [](const Container &c, uint16_t k) { return c.key < k; });
+        if (it == containers.end() || it->key != hi) {
+            it = containers.insert(it, Container());
+            it->key = hi;
+        }
+        return it->add(lo);
+    }
+
+    void promote() {
+        for (uint32_t v : small) addToContainer((int)v);
+        vector<uint32_t>().swap(small);
+    }
 
-    SkillNode() : isEnd(false), wordCount(0) {
-        next.fill(nullptr);
+    void demote() {
+        vector<uint32_t> ids;
+        ids.reserve(size());
+        forEach([&](int id) { ids.push_back((uint32_t)id); });
+        containers.clear();
+        small.swap(ids);
     }
+
+    struct Container {
+        uint16_t key = 0;
+        uint32_t card = 0;
+        vector<uint16_t> array;  // sorted, while card <= kArrayMax
+        vector<uint64_t> bitmap; // 1024 words once larger
+
+        bool add(uint16_t lo) {
+            if (!bitmap.empty()) {
+                uint64_t bit = 1ULL << (lo & 63);
+                if (bitmap[lo >> 6] & bit) return false;
+                bitmap[lo >> 6] |= bit;
+                card++;
+                return true;
+            }
+            auto it = (array.empty() || array.back() < lo) ? array.end() : lower_bound(array.begin(), array.end(), lo);
+            if (it != array.end() && *it == lo) return false;
+            array.insert(it, lo);
+            if (++card > kArrayMax) toBitmap();
+            return true;
+        }
+
+        bool contains(uint16_t lo) const {
+            if (!bitmap.empty()) return bitmap[lo >> 6] >> (lo & 63) & 1;
+            return binary_search(array.begin(), array.end(), lo);
+        }
+
+        void toBitmap() {
+            bitmap.assign(1024, 0);
+            for (uint16_t lo : array) bitmap[lo >> 6] |= 1ULL << (lo & 63);
+            vector<uint16_t>().swap(array);
+        }
+
+        // after an operation: back to an array if it got small
+        void settle() {
+            if (bitmap.empty()) {
+                card = (uint32_t)array.size();
+                if (card > kArrayMax) toBitmap();
+                return;
+            }
+            card = 0;
+            for (uint64_t w : bitmap) card += __builtin_popcountll(w);
+            if (card > kArrayMax) return;
+            for (int w = 0; w < 1024; w++)
+                for (uint64_t bits = bitmap[w]; bits; bits &= bits - 1)
+                    array.push_back((uint16_t)(w << 6 | __builtin_ctzll(bits)));
+            vector<uint64_t>().swap(bitmap);
+        }
+    };
+
+    static PostingList combine(const PostingList &a, const PostingList &b, Op op) {
+        PostingList out;
+        if (a.containers.empty() && b.containers.empty()) {
+            auto &x = a.small, &y = b.small;
+            if (op == Op::And) intersectSorted(x, y, out.small);
+            else if (op == Op::Or) set_union(x.begin(), x.end(), y.begin(), y.end(), back_inserter(out.small));
+            else set_difference(x.begin(), x.end(), y.begin(), y.end(), back_inserter(out.small));
+            if (out.small.size() > kSmallMax) out.promote();
+            return out;
+        }
+        if (a.containers.empty() && op != Op::Or) {
+            filterSmall(a.small, b, op == Op::And, out.small);
+            return out;
+        }
+        if (b.containers.empty() && op == Op::And) return combine(b, a, op);
+        if (a.containers.empty() || b.containers.empty()) {
+            // remaining mixed forms (a OR b, a AND NOT b): lift the small side
+            // into containers; an empty side has nothing to lift
+            if (a.empty()) return b;
+            if (b.empty()) return a;
+            PostingList lifted = a.containers.empty() ? a : b;
+            lifted.promote();
+            return a.containers.empty() ? combine(lifted, b, op) : combine(a, lifted, op);
+        }
+        size_t i = 0, j = 0;
+        while (i < a.containers.size() || j < b.containers.size()) {
+            bool haveA = i < a.containers.size(), haveB = j < b.containers.size();
+            if (haveA && (!haveB || a.containers[i].key < b.containers[j].key)) {
+                if (op != Op::And) out.containers.push_back(a.containers[i]);
+                i++;
+            } else if (haveB && (!haveA || b.containers[j].key < a.containers[i].key)) {
+                if (op == Op::Or) out.containers.push_back(b.containers[j]);
+                j++;
+            } else {
+                Container c = combine(a.containers[i++], b.containers[j++], op);
+                if (c.card) out.containers.push_back(move(c));
+            }
+        }
+        if (out.size() <= kSmallMax) out.demote();
+        return out;
+    }
+
+    // the ids of small that are (keep == true) or are not in large, which is
+    // in container form. small is cut into runs sharing high 16 bits; a run
+    // is tested bit by bit against a bitmap container and intersected with
+    // an array container like two arrays.
+    static void filterSmall(const vector<uint32_t> &small, const PostingList &large, bool keep, vector<uint32_t> &out) {
+        vector<uint16_t> lows, hits;
+        size_t c = 0;
+        for (size_t i = 0; i < small.size();) {
+            uint32_t hi = small[i] >> 16;
+            size_t j = i;
+            while (j < small.size() && small[j] >> 16 == hi) j++;
+            while (c < large.containers.size() && large.containers[c].key < hi) c++;
+            const Container *box = c < large.containers.size() && large.containers[c].key == hi ? &large.containers[c] : nullptr;
+            if (!box) {
+                if (!keep) out.insert(out.end(), small.begin() + i, small.begin() + j);
+            } else if (!box->bitmap.empty()) {
+                for (size_t k = i; k < j; k++)
+                    if (box->contains(small[k] & 0xFFFF) == keep) out.push_back(small[k]);
+            } else {
+                lows.clear();
+                hits.clear();
+                for (size_t k = i; k < j; k++) lows.push_back(small[k] & 0xFFFF);
+                intersectSorted(lows, box->array, hits);
+                if (keep) {
+                    for (uint16_t lo : hits) out.push_back(hi << 16 | lo);
+                } else {
+                    size_t h = 0;
+                    for (uint16_t lo : lows) {
+                        if (h < hits.size() && hits[h] == lo) h++;
+                        else out.push_back(hi << 16 | lo);
+                    }
+                }
+            }
+            i = j;
+        }
+    }
+
+    static Container combine(const Container &a, const Container &b, Op op) {
+        Container out;
+        out.key = a.key;
+        bool bitA = !a.bitmap.empty(), bitB = !b.bitmap.empty();
+        if (bitA && bitB) {
+            out.bitmap.resize(1024);
+            for (int w = 0; w < 1024; w++) {
+                uint64_t x = a.bitmap[w], y = b.bitmap[w];
+                out.bitmap[w] = op == Op::And ? x & y : op == Op::Or ? x | y : x & ~y;
+            }
+        } else if (!bitA && !bitB) {
+            if (op == Op::And) intersectSorted(a.array, b.array, out.array);
+            else if (op == Op::Or) set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), back_inserter(out.array));
+            else set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), back_inserter(out.array));
+        } else if (op == Op::And) {
+            const Container &arr = bitA ? b : a, &bits = bitA ? a : b;
+            for (uint16_t lo : arr.array) if (bits.contains(lo)) out.array.push_back(lo);
+        } else if (op == Op::Or) {
+            out = bitA ? a : b;
+            for (uint16_t lo : (bitA ? b : a).array) out.bitmap[lo >> 6] |= 1ULL << (lo & 63);
+        } else if (bitA) { // bitmap minus array
+            out = a;
+            for (uint16_t lo : b.array) out.bitmap[lo >> 6] &= ~(1ULL << (lo & 63));
+        } else {           // array minus bitmap
+            for (uint16_t lo : a.array) if (!b.contains(lo)) out.array.push_back(lo);
+        }
+        out.settle();
+        return out;
+    }
+
+    // how many of the first n values of v (n <= one SSE register) are below x
+    template <typename T>
+    static size_t countBelow(const T *v, size_t n, size_t avail, T x) {
+#ifdef __SSE2__
+        if (avail >= 16 / sizeof(T)) {
+            // unsigned compare via the signed one: flip the top bit of both sides
+            __m128i block = _mm_loadu_si128((const __m128i *)v), below;
+            if constexpr (sizeof(T) == 2) {
+                const __m128i bias = _mm_set1_epi16((short)0x8000);
+                below = _mm_cmplt_epi16(_mm_xor_si128(block, bias), _mm_xor_si128(_mm_set1_epi16((short)x), bias));
+            } else {
+                const __m128i bias = _mm_set1_epi32((int)0x80000000);
+                below = _mm_cmplt_epi32(_mm_xor_si128(block, bias), _mm_xor_si128(_mm_set1_epi32((int)x), bias));
+            }
+            unsigned mask = (unsigned)_mm_movemask_epi8(below) & ((1u << (sizeof(T) * n)) - 1);
+            return __builtin_popcount(mask) / sizeof(T);
+        }
+#endif
+        (void)avail;
+        size_t c = 0;
+        while (c < n && v[c] < x) c++;
+        return c;
+    }
+
+    // Sorted intersection. Similar sizes: linear merge. Skewed sizes: for each
+    // value of the small side, gallop over the large side, binary search down
+    // to one SSE register's worth of values and finish with a single compare.
+    template <typename T>
+    static void intersectSorted(const vector<T> &a, const vector<T> &b, vector<T> &out) {
+        const vector<T> &small = a.size() <= b.size() ? a : b;
+        const vector<T> &large = a.size() <= b.size() ? b : a;
+        if (small.empty()) return;
+        if (large.size() < 16 * small.size()) {
+            set_intersection(small.begin(), small.end(), large.begin(), large.end(), back_inserter(out));
+            return;
+        }
+        const size_t lanes = 16 / sizeof(T);
+        const size_t n = large.size();
+        size_t pos = 0;
+        for (T x : small) {
+            if (pos >= n || large[n - 1] < x) break;
+            size_t jump = 1;
+            while (pos + jump < n && large[pos + jump] < x) jump <<= 1;
+            size_t lo = pos + jump / 2, hi = min(n, pos + jump + 1); // first value >= x is in [lo, hi)
+            while (hi - lo > lanes) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (large[mid] < x) lo = mid + 1;
+                else hi = mid + 1;
+            }
+            pos = lo + countBelow(&large[lo], hi - lo, n - lo, x);
+            if (pos < n && large[pos] == x) out.push_back(x);
+        }
+    }
+};
+
+// Boolean skill query: profiles with every skill in allOf, at least one skill
+// of each anyOf group, and no skill in noneOf.
+struct SkillQuery {
+    vector<string> allOf;
+    vector<vector<string>> anyOf;
+    vector<string> noneOf;
+
+    // "python AND pandas AND NOT java", "rust AND (go OR cpp)",
+    // "NOT (php OR perl)": clauses joined by AND, each an optionally negated
+    // skill or OR-group
+    static SkillQuery parse(const string &text) {
+        vector<string> tokens;
+        string cur;
+        for (char c : text) {
+            if (isspace((unsigned char)c) || c == '(' || c == ')') {
+                if (!cur.empty()) tokens.push_back(cur);
+                cur.clear();
+                if (c != ' ' && !isspace((unsigned char)c)) tokens.push_back(string(1, c));
+            } else {
+                cur.push_back(c);
+            }
+        }
+        if (!cur.empty()) tokens.push_back(cur);
+
+        SkillQuery q;
+        size_t i = 0;
+        auto at = [&](const char *t) { return i < tokens.size() && tokens[i] == t; };
+        while (i < tokens.size()) {
+            bool negated = at("NOT");
+            if (negated) i++;
+            vector<string> group;
+            bool paren = at("(");
+            if (paren) i++;
+            while (i < tokens.size() && !at(")") && !at("AND")) {
+                if (!at("OR")) group.push_back(tokens[i]);
+                i++;
+            }
+            if (paren && at(")")) i++;
+            if (negated) q.noneOf.insert(q.noneOf.end(), group.begin(), group.end());
+            else if (group.size() == 1) q.allOf.push_back(group[0]);
+            else if (!group.empty()) q.anyOf.push_back(group);
+            if (at("AND")) i++;
+        }
+        return q;
+    }
+};
+
+// A completion ranked by popularity (number of linked profiles).
+struct SkillSuggestion {
+    string skill;
+    int popularity;
+};
+
+// A skill within some edit distance of a (mistyped) query.
+struct FuzzyMatch {
+    string skill;
+    int distance;
+    vector<int> profiles;
+};
+
+// SkillTrie image file: "SKTI", u32 version, counts, then three arrays at the
+// byte offsets in the header. Links between nodes are array indices, so the
+// file works at any address and is queried in place after mmap.
+//   nodes    : BFS order; the children of a node are contiguous, in letter
+//              order, so a child's index is firstChild plus the number of
+//              lower letters set in mask
+//   ranges   : skillCount + 1 entries; skill k owns postings[ranges[k], ranges[k + 1])
+//   postings : ascending profile ids per skill
+struct SkillImageHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t skillCount;
+    uint64_t postingCount;
+    uint64_t nodesAt;
+    uint64_t rangesAt;
+    uint64_t postingsAt;
 };
 
+struct SkillImageNode {
+    uint32_t mask;       // bit c set: child for letter 'a' + c
+    uint32_t firstChild; // index of the lowest-letter child
+    uint32_t skill;      // slot in ranges, UINT32_MAX if no skill ends here
+};
+static_assert(sizeof(SkillImageNode) == 12, "SkillImageNode is a fixed 12-byte record");
+
 // The main trie class for storing skills and performing prefix queries.
 class SkillTrie {
 public:
+    // suggestions up to this many per prefix are served from node caches
+    static constexpr int kTopK = 8;
+
     SkillTrie() {
-        root = new SkillNode();
+        nodes.emplace_back(); // root
+        topCache.emplace_back();
+        topCache.back().fill(kNone);
     }
 
-    void insertSkill(const string &skill, int profileId) {
-        SkillNode* cur = root;
-        for (char c : skill) {
-            if (isalpha(c) == false) continue;
-            char x = tolower(c);
-            int idx = x - 'a';
-            if (idx < 0 || idx >= 26) continue;
-            if (cur->next[idx] == nullptr) {
-                cur->next[idx] = new SkillNode();
+    // Build a trie from (skill, profileId) links in one pass instead of one
+    // insertSkill per link. Links are partitioned in place by first letter;
+    // each bucket is sorted and laid out bottom-up on its own thread, straight
+    // into its slice of the shared pool. Same queries and counters as the
+    // incremental build.
+    static SkillTrie bulkBuild(vector<pair<string, int>> links, unsigned threads = 0) {
+        // bucket 0: skills with no letters, 1 + c: skills starting with 'a' + c
+        auto bucketOf = [](const pair<string, int> &l) { return l.first.empty() ? 0 : l.first[0] - 'a' + 1; };
+        array<size_t, 28> from{};
+        for (auto &l : links) {
+            l.first = normalize(l.first);
+            from[bucketOf(l) + 1]++;
+        }
+        for (int b = 1; b < 28; b++) from[b] += from[b - 1];
+        array<size_t, 27> fill;
+        copy(from.begin(), from.begin() + 27, fill.begin());
+        for (int b = 0; b < 27; b++) { // swap every link into its bucket
+            while (fill[b] < from[b + 1]) {
+                int home = bucketOf(links[fill[b]]);
+                if (home == b) fill[b]++;
+                else swap(links[fill[b]], links[fill[home]++]);
             }
-            cur = cur->next[idx];
-            cur->wordCount++;
         }
-        cur->isEnd = true;
-        cur->linkedProfiles.push_back(profileId);
+        const pair<string, int> *base = links.data();
+        auto first = [&](int b) { return base + from[b]; };
+        auto last = [&](int b) { return base + from[b + 1]; };
+
+        auto forLetters = [&](auto fn) {
+            atomic<int> next{ 1 };
+            auto work = [&]() {
+                for (int b; (b = next++) < 27;) fn(b);
+            };
+            unsigned n = threads ? threads : max(1u, thread::hardware_concurrency());
+            vector<thread> pool;
+            for (unsigned t = 1; t < min(n, 26u); t++) pool.emplace_back(work);
+            work();
+            for (auto &t : pool) t.join();
+        };
+
+        // pass 1: sort each bucket and size its slice of the pool
+        array<size_t, 27> nodeCount{}, skillCount{};
+        forLetters([&](int b) {
+            sort(links.begin() + from[b], links.begin() + from[b + 1]);
+            countSorted(first(b), last(b), nodeCount[b], skillCount[b]);
+        });
+        countSorted(first(0), last(0), nodeCount[0], skillCount[0]);
+
+        SkillTrie trie;
+        array<uint32_t, 27> nodeAt, skillAt;
+        size_t nodes = 1, skills = 0;
+        for (int b = 0; b < 27; b++) {
+            nodeAt[b] = (uint32_t)nodes;
+            skillAt[b] = (uint32_t)skills;
+            nodes += nodeCount[b];
+            skills += skillCount[b];
+        }
+        trie.nodes.resize(nodes);
+        trie.topCache.resize(nodes);
+        trie.postings.resize(skills);
+        trie.skillNames.resize(skills);
+
+        // pass 2: fill the slices; buckets only share the root, each writing
+        // its own letter's child slot
+        forLetters([&](int b) { trie.buildSorted(first(b), last(b), nodeAt[b], skillAt[b]); });
+        trie.buildSorted(first(0), last(0), nodeAt[0], skillAt[0]);
+        SkillNode &root = trie.nodes[0];
+        if (root.isEnd) {
+            root.wordCount = (int)trie.postings[root.postings].size();
+            root.skillCount = 1;
+        }
+        for (uint32_t child : root.next) {
+            if (!child) continue;
+            root.wordCount += trie.nodes[child].wordCount;
+            root.skillCount += trie.nodes[child].skillCount;
+        }
+        trie.fillTopCache(0);
+        return trie;
     }
 
-    bool containsSkill(const string &skill) {
-        SkillNode* cur = root;
-        for (char c : skill) {
-            if (!isalpha(c)) continue;
-            char x = tolower(c);
+    void insertSkill(const string &skill, int profileId) {
+        string key = normalize(skill);
+        uint32_t cur = 0;
+        for (char x : key) {
             int idx = x - 'a';
-            if (idx < 0 || idx >= 26) return false;
-            if (cur->next[idx] == nullptr) return false;
-            cur = cur->next[idx];
+            uint32_t nxt = nodes[cur].next[idx];
+            if (nxt == 0) {
+                nxt = (uint32_t)nodes.size();
+                nodes.emplace_back(); // may move the pool: keep indices only
+                topCache.emplace_back();
+                topCache.back().fill(kNone);
+                nodes[cur].next[idx] = nxt;
+            }
+            cur = nxt;
+        }
+        SkillNode &end = nodes[cur];
+        bool newSkill = !end.isEnd;
+        if (newSkill) {
+            end.isEnd = true;
+            end.postings = (uint32_t)postings.size();
+            postings.emplace_back();
+            skillNames.push_back(key);
         }
-        return cur->isEnd;
+        uint32_t skillId = end.postings;
+        if (!postings[skillId].add(profileId)) return; // already linked
+
+        // one more link (maybe a new skill) below every node on the path, and
+        // this skill's popularity went up by one: fix counters and caches
+        cur = 0;
+        for (size_t d = 0;; d++) {
+            nodes[cur].wordCount++;
+            nodes[cur].skillCount += newSkill;
+            promote(cur, skillId);
+            if (d == key.size()) break;
+            cur = nodes[cur].next[key[d] - 'a'];
+        }
+    }
+
+    // distinct skills starting with prefix; O(|prefix|)
+    int countSkillsWithPrefix(const string &prefix) const {
+        int node = findNode(prefix);
+        return node < 0 ? 0 : nodes[node].skillCount;
+    }
+
+    // (skill, profile) links under prefix, i.e. profiles counted once per
+    // matching skill; O(|prefix|)
+    int countLinksWithPrefix(const string &prefix) const {
+        int node = findNode(prefix);
+        return node < 0 ? 0 : nodes[node].wordCount;
+    }
+
+    // skillsWithPrefix(prefix)[offset, offset + limit) without building the
+    // rest: subtrees holding fewer skills than are still to be skipped are
+    // stepped over whole, so a deep page costs O(depth * 26 + limit) like
+    // the first one
+    vector<string> skillsWithPrefix(const string &prefix, size_t offset, size_t limit) const {
+        vector<string> result;
+        int node = findNode(prefix);
+        if (node < 0 || limit == 0) return result;
+        string current = prefix;
+        page((uint32_t)node, current, offset, limit, result);
+        return result;
+    }
+
+    bool containsSkill(const string &skill) const {
+        int cur = walk(skill);
+        return cur >= 0 && nodes[cur].isEnd;
     }
 
     vector<string> skillsWithPrefix(const string &prefix) {
-        SkillNode* node = findNode(prefix);
+        int node = findNode(prefix);
         vector<string> result;
-        if (!node) return result;
+        if (node < 0) return result;
         string current = prefix;
         explore(node, current, result);
         return result;
     }
 
-    vector<int> profileMatches(const string &skill) {
-        SkillNode* cur = root;
-        for (char c : skill) {
+    vector<int> profileMatches(const string &skill) const {
+        int cur = walk(skill);
+        if (cur < 0 || nodes[cur].isEnd == false) return {};
+        return postings[nodes[cur].postings].toVector();
+    }
+
+    // fn(skill, postings) for each skill under prefix, alphabetically, until
+    // fn returns false; false if it did. skill views the trie's name table
+    // (valid until the next insert), so nothing is built or copied.
+    template <typename Fn>
+    bool visitSkills(const string &prefix, Fn fn) const {
+        int node = findNode(prefix);
+        return node < 0 || visitFrom((uint32_t)node, fn);
+    }
+
+    // posting list of skill, or nullptr
+    const PostingList *postingList(string_view skill) const {
+        int cur = walk(skill);
+        if (cur < 0 || nodes[cur].isEnd == false) return nullptr;
+        return &postings[nodes[cur].postings];
+    }
+
+    // skills within maxEdits Levenshtein edits of query (meant for k <= 2),
+    // nearest first. The DP row for each trie depth is shared by the whole
+    // subtree and a subtree is skipped once no cell in its row is <= maxEdits.
+    vector<FuzzyMatch> fuzzyMatches(const string &query, int maxEdits) {
+        string q;
+        for (char c : query) {
             if (!isalpha(c)) continue;
-            int idx = tolower(c) - 'a';
-            if (idx < 0 || idx >= 26) return {};
-            if (cur->next[idx] == nullptr) return {};
-            cur = cur->next[idx];
+            char x = tolower(c);
+            if (x >= 'a' && x <= 'z') q.push_back(x);
+        }
+        vector<FuzzyMatch> out;
+        if (maxEdits < 0) return out;
+        int width = (int)q.size() + 1;
+        vector<int> rows(width);
+        for (int j = 0; j < width; j++) rows[j] = j;
+        fuzzyWalk(0, 0, q, maxEdits, rows, out);
+        sort(out.begin(), out.end(), [](const FuzzyMatch &a, const FuzzyMatch &b) {
+            return a.distance != b.distance ? a.distance < b.distance : a.skill < b.skill;
+        });
+        return out;
+    }
+
+    // the k most popular skills under prefix, most popular first and equally
+    // popular ones by name; O(|prefix| + k) for k <= kTopK, a full subtree
+    // walk beyond that. The ranking does not depend on insertion order, so
+    // incremental and bulk-built tries agree.
+    vector<SkillSuggestion> topSkillsWithPrefix(const string &prefix, int k) {
+        vector<SkillSuggestion> out;
+        int node = findNode(prefix);
+        if (node < 0 || k <= 0) return out;
+        if (k <= kTopK) {
+            for (uint32_t id : topCache[node]) {
+                if (id == kNone || (int)out.size() == k) break;
+                out.push_back({ skillNames[id], (int)postings[id].size() });
+            }
+            return out;
+        }
+        vector<uint32_t> ids;
+        collectIds(node, [&](uint32_t id) { ids.push_back(id); });
+        auto byRank = [&](uint32_t a, uint32_t b) { return ranksAbove(a, b); };
+        size_t keep = min(ids.size(), (size_t)k);
+        partial_sort(ids.begin(), ids.begin() + keep, ids.end(), byRank);
+        for (size_t i = 0; i < keep; i++) out.push_back({ skillNames[ids[i]], popularity(ids[i]) });
+        return out;
+    }
+
+    // lower-case letters of s; everything else is dropped.
+    // Lookups walk the same key, so this is the name a skill is stored under
+    static string normalize(const string &s) {
+        string key;
+        for (char c : s) {
+            if (isalpha(c) == false) continue;
+            char x = tolower(c);
+            int idx = x - 'a';
+            if (idx < 0 || idx >= 26) continue;
+            key.push_back(x);
+        }
+        return key;
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+    size_t distinctSkills() const { return postings.size(); }
+
+    // heap bytes held by the pool, the posting lists and the skill table
+    // (the suggestion caches are reported separately)
+    size_t memoryBytes() const {
+        size_t bytes = nodes.capacity() * sizeof(SkillNode) + skillNames.capacity() * sizeof(string);
+        for (auto &p : postings) bytes += p.memoryBytes();
+        for (auto &s : skillNames) if (s.capacity() > 15) bytes += s.capacity() + 1;
+        return bytes;
+    }
+
+    size_t suggestionCacheBytes() const { return topCache.capacity() * sizeof(topCache[0]); }
+
+    // write the trie (skills and postings, not the suggestion caches) as an
+    // image for SkillTrieImage; false if the file cannot be written
+    bool writeImage(const string &path) const {
+        vector<SkillImageNode> image;
+        vector<uint32_t> order{ 0 }; // pool index of each image node
+        vector<uint32_t> skills;     // postings slot of each image skill
+        vector<uint64_t> ranges{ 0 };
+        image.reserve(nodes.size());
+        order.reserve(nodes.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            const SkillNode &n = nodes[order[i]];
+            SkillImageNode out{ 0, (uint32_t)order.size(), kNone };
+            for (int c = 0; c < 26; c++) {
+                if (!n.next[c]) continue;
+                out.mask |= 1u << c;
+                order.push_back(n.next[c]);
+            }
+            if (n.isEnd) {
+                out.skill = (uint32_t)skills.size();
+                skills.push_back(n.postings);
+                ranges.push_back(ranges.back() + postings[n.postings].size());
+            }
+            image.push_back(out);
+        }
+
+        auto align8 = [](uint64_t x) { return (x + 7) & ~uint64_t(7); };
+        SkillImageHeader h{ { 'S', 'K', 'T', 'I' }, 1, (uint32_t)image.size(), (uint32_t)skills.size(), ranges.back(), 0, 0, 0 };
+        h.nodesAt = sizeof(SkillImageHeader);
+        h.rangesAt = align8(h.nodesAt + image.size() * sizeof(SkillImageNode));
+        h.postingsAt = h.rangesAt + ranges.size() * sizeof(uint64_t);
+
+        FILE *f = fopen(path.c_str(), "wb");
+        if (!f) return false;
+        setvbuf(f, nullptr, _IOFBF, 1 << 20);
+        static const char pad[8] = {};
+        fwrite(&h, sizeof(h), 1, f);
+        fwrite(image.data(), sizeof(SkillImageNode), image.size(), f);
+        fwrite(pad, 1, h.rangesAt - (h.nodesAt + image.size() * sizeof(SkillImageNode)), f);
+        fwrite(ranges.data(), sizeof(uint64_t), ranges.size(), f);
+        vector<uint32_t> chunk;
+        for (uint32_t slot : skills) {
+            postings[slot].forEach([&](int id) {
+                chunk.push_back((uint32_t)id);
+                if (chunk.size() == (1 << 16)) {
+                    fwrite(chunk.data(), sizeof(uint32_t), chunk.size(), f);
+                    chunk.clear();
+                }
+            });
         }
-        if (cur->isEnd == false) return {};
-        return cur->linkedProfiles;
+        fwrite(chunk.data(), sizeof(uint32_t), chunk.size(), f);
+        bool ok = !ferror(f);
+        return fclose(f) == 0 && ok;
+    }
+
+    // what the same trie costs with one heap PointerSkillNode per character
+    size_t pointerLayoutBytes() const {
+        size_t bytes = nodes.size() * sizeof(PointerSkillNode);
+        for (auto &p : postings) bytes += p.size() * sizeof(int);
+        return bytes;
     }
 
 private:
-    SkillNode* root;
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    vector<SkillNode> nodes;
+    vector<PostingList> postings; // profile ids per distinct skill
+    vector<string> skillNames;    // normalised skill per postings slot
+    vector<array<uint32_t, kTopK>> topCache; // per node: most popular skill ids below it, best first
+
+    int popularity(uint32_t id) const { return (int)postings[id].size(); }
 
-    SkillNode* findNode(const string &s) {
-        SkillNode* cur = root;
+    // suggestion order: more popular first, ties by name
+    bool ranksAbove(uint32_t a, uint32_t b) const {
+        int pa = popularity(a), pb = popularity(b);
+        return pa != pb ? pa > pb : skillNames[a] < skillNames[b];
+    }
+
+    // nodes (root excluded) and distinct skills that sorted links add to an
+    // empty trie
+    static void countSorted(const pair<string, int> *first, const pair<string, int> *last, size_t &nodeCount, size_t &skillCount) {
+        const string *prev = nullptr;
+        for (auto *l = first; l != last; l++) {
+            const string &key = l->first;
+            if (prev && *prev == key) continue;
+            size_t common = 0;
+            if (prev) while (common < prev->size() && common < key.size() && (*prev)[common] == key[common]) common++;
+            nodeCount += key.size() - common;
+            skillCount++;
+            prev = &key;
+        }
+    }
+
+    // Lay out [first, last) (normalised, sorted, not sharing any node but the root
+    // with other calls) into pool slots from nodeAt and skill slots from
+    // skillAt, sized by countSorted. Each key only differs from the previous
+    // one below their common prefix, so the current root-to-leaf path is all
+    // the state needed. Nodes come out in preorder, which lets the suggestion
+    // caches be filled bottom-up by a reverse scan.
+    void buildSorted(const pair<string, int> *first, const pair<string, int> *last, uint32_t nodeAt, uint32_t skillAt) {
+        vector<uint32_t> path{ 0 };
+        uint32_t nextNode = nodeAt, nextSkill = skillAt;
+        const string *prev = nullptr;
+        for (auto *i = first; i != last;) {
+            const string &key = i->first;
+            auto *j = i;
+            while (j != last && j->first == key) j++;
+            size_t common = 0;
+            if (prev) while (common < prev->size() && common < key.size() && (*prev)[common] == key[common]) common++;
+            path.resize(common + 1);
+            for (size_t d = common; d < key.size(); d++) {
+                nodes[path.back()].next[key[d] - 'a'] = nextNode;
+                path.push_back(nextNode++);
+            }
+            SkillNode &end = nodes[path.back()];
+            end.isEnd = true;
+            end.postings = nextSkill++;
+            skillNames[end.postings] = key;
+            int linked = 0;
+            for (auto *k = i; k != j; k++) linked += postings[end.postings].add(k->second); // ascending: appends
+            for (size_t d = 1; d < path.size(); d++) { // the shared root is summed up by bulkBuild
+                nodes[path[d]].wordCount += linked;
+                nodes[path[d]].skillCount++;
+            }
+            prev = &key;
+            i = j;
+        }
+        for (uint32_t n = nextNode; n-- > nodeAt;) fillTopCache(n);
+    }
+
+    // node's cache from its own skill and its children's caches
+    void fillTopCache(uint32_t node) {
+        uint32_t cand[26 * kTopK + 1];
+        int n = 0;
+        if (nodes[node].isEnd) cand[n++] = nodes[node].postings;
+        for (uint32_t child : nodes[node].next) {
+            if (!child) continue;
+            for (uint32_t id : topCache[child]) {
+                if (id == kNone) break;
+                cand[n++] = id;
+            }
+        }
+        int keep = min(n, kTopK);
+        partial_sort(cand, cand + keep, cand + n, [&](uint32_t a, uint32_t b) { return ranksAbove(a, b); });
+        topCache[node].fill(kNone);
+        copy(cand, cand + keep, topCache[node].begin());
+    }
+
+    // id's popularity just grew by one; keep node's cache the top kTopK of its
+    // subtree by ranksAbove (popularity never drops, so the entry can only
+    // move up)
+    void promote(uint32_t node, uint32_t id) {
+        auto &top = topCache[node];
+        int pos = 0;
+        while (pos < kTopK && top[pos] != id) pos++;
+        if (pos == kTopK) {
+            if (top[kTopK - 1] != kNone && ranksAbove(top[kTopK - 1], id)) return;
+            pos = kTopK - 1;
+            top[pos] = id;
+        }
+        while (pos > 0 && (top[pos - 1] == kNone || ranksAbove(id, top[pos - 1]))) {
+            swap(top[pos - 1], top[pos]);
+            pos--;
+        }
+    }
+
+    // rows holds one DP row of width |q| + 1 per depth on the current path
+    void fuzzyWalk(uint32_t node, int depth, const string &q, int maxEdits, vector<int> &rows, vector<FuzzyMatch> &out) {
+        int width = (int)q.size() + 1;
+        const SkillNode &n = nodes[node];
+        int here = rows[depth * width + width - 1];
+        if (n.isEnd && here <= maxEdits) out.push_back({ skillNames[n.postings], here, postings[n.postings].toVector() });
+        if ((int)rows.size() < (depth + 2) * width) rows.resize((depth + 2) * width);
+        for (int i = 0; i < 26; i++) {
+            uint32_t child = nodes[node].next[i];
+            if (!child) continue;
+            const int *prev = &rows[depth * width]; // re-fetched: deeper calls may grow rows
+            int *cur = &rows[(depth + 1) * width];
+            cur[0] = depth + 1;
+            int best = cur[0];
+            for (int j = 1; j < width; j++) {
+                int sub = prev[j - 1] + (q[j - 1] != 'a' + i);
+                cur[j] = min(sub, min(prev[j], cur[j - 1]) + 1);
+                best = min(best, cur[j]);
+            }
+            if (best <= maxEdits) fuzzyWalk(child, depth + 1, q, maxEdits, rows, out);
+        }
+    }
+
+    void page(uint32_t node, string &current, size_t &skip, size_t limit, vector<string> &out) const {
+        if (nodes[node].isEnd) {
+            if (skip > 0) skip--;
+            else out.push_back(current);
+        }
+        for (int i = 0; i < 26 && out.size() < limit; i++) {
+            uint32_t child = nodes[node].next[i];
+            if (!child) continue;
+            if (skip >= (size_t)nodes[child].skillCount) {
+                skip -= nodes[child].skillCount;
+                continue;
+            }
+            current.push_back('a' + i);
+            page(child, current, skip, limit, out);
+            current.pop_back();
+        }
+    }
+
+    template <typename Fn>
+    bool visitFrom(uint32_t node, Fn &fn) const {
+        const SkillNode &n = nodes[node];
+        if (n.isEnd && !fn(string_view(skillNames[n.postings]), postings[n.postings])) return false;
+        for (uint32_t child : n.next)
+            if (child && !visitFrom(child, fn)) return false;
+        return true;
+    }
+
+    template <typename Fn>
+    void collectIds(uint32_t node, Fn fn) const {
+        if (nodes[node].isEnd) fn(nodes[node].postings);
+        for (int i = 0; i < 26; i++)
+            if (nodes[node].next[i]) collectIds(nodes[node].next[i], fn);
+    }
+
+    // node reached by s, or -1; characters outside a-z fail the lookup
+    int walk(string_view s) const {
+        uint32_t cur = 0;
         for (char c : s) {
             if (!isalpha(c)) continue;
             int idx = tolower(c) - 'a';
-            if (idx < 0 || idx >= 26) return nullptr;
-            if (cur->next[idx] == nullptr) return nullptr;
-            cur = cur->next[idx];
+            if (idx < 0 || idx >= 26) return -1;
+            if (nodes[cur].next[idx] == 0) return -1;
+            cur = nodes[cur].next[idx];
         }
-        return cur;
+        return (int)cur;
     }
 
-    void explore(SkillNode* node, string &current, vector<string> &out) {
-        if (node->isEnd) out.push_back(current);
+    int findNode(string_view s) const {
+        return walk(s);
+    }
+
+    void explore(uint32_t node, string &current, vector<string> &out) {
+        if (nodes[node].isEnd) out.push_back(current);
         for (int i = 0; i < 26; i++) {
-            if (node->next[i]) {
+            if (nodes[node].next[i]) {
                 current.push_back('a' + i);
-                explore(node->next[i], current, out);
+                explore(nodes[node].next[i], current, out);
                 current.pop_back();
             }
         }
     }
 };
 
+// Read-only mmap of a SkillTrie image. Queries walk the mapped nodes and read
+// postings in place; opening costs a header check, not a rebuild. Indices from
+// the file are bounds-checked as they are followed, so a damaged image fails
+// lookups rather than reading outside the mapping.
+class SkillTrieImage {
+public:
+    explicit SkillTrieImage(const string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(SkillImageHeader)) {
+            void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                base = p;
+                length = st.st_size;
+            }
+        }
+        ::close(fd);
+        if (!base) return;
+        auto *h = static_cast<const SkillImageHeader *>(base);
+        auto fits = [&](uint64_t at, uint64_t count, uint64_t width) {
+            return at % width == 0 && at <= length && count <= (length - at) / width;
+        };
+        if (memcmp(h->magic, "SKTI", 4) != 0 || h->version != 1 || h->nodeCount == 0 ||
+            !fits(h->nodesAt, h->nodeCount, sizeof(SkillImageNode)) ||
+            !fits(h->rangesAt, (uint64_t)h->skillCount + 1, sizeof(uint64_t)) ||
+            !fits(h->postingsAt, h->postingCount, sizeof(uint32_t))) {
+            ::munmap(base, length);
+            base = nullptr;
+            return;
+        }
+        const char *bytes = static_cast<const char *>(base);
+        header = h;
+        nodes = reinterpret_cast<const SkillImageNode *>(bytes + h->nodesAt);
+        ranges = reinterpret_cast<const uint64_t *>(bytes + h->rangesAt);
+        ids = reinterpret_cast<const uint32_t *>(bytes + h->postingsAt);
+        ::madvise(base, length, MADV_RANDOM);
+    }
+
+    ~SkillTrieImage() {
+        if (base) ::munmap(base, length);
+    }
+
+    SkillTrieImage(const SkillTrieImage &) = delete;
+    SkillTrieImage &operator=(const SkillTrieImage &) = delete;
+
+    bool ok() const { return base != nullptr; }
+    size_t nodeCount() const { return ok() ? header->nodeCount : 0; }
+    size_t distinctSkills() const { return ok() ? header->skillCount : 0; }
+    size_t fileBytes() const { return length; }
+
+    bool containsSkill(const string &skill) const {
+        int64_t node = walk(skill);
+        return node >= 0 && nodes[node].skill != kNoSkill;
+    }
+
+    vector<string> skillsWithPrefix(const string &prefix) const {
+        vector<string> result;
+        visitSkills(prefix, [&](const string &skill, const uint32_t *, const uint32_t *) {
+            result.push_back(skill);
+            return true;
+        });
+        return result;
+    }
+
+    // fn(skill, first, last) for each skill under prefix, alphabetically,
+    // with its profile ids in place as [first, last), until fn returns false;
+    // false if it did. skill is only valid during the call.
+    template <typename Fn>
+    bool visitSkills(const string &prefix, Fn fn) const {
+        int64_t node = walk(prefix);
+        if (node < 0) return true;
+        string current;
+        for (char c : prefix)
+            if (isalpha(c)) current.push_back(tolower(c));
+        return visitFrom((uint32_t)node, current, fn);
+    }
+
+    // SkillTrie::fuzzyMatches over the mapped nodes
+    vector<FuzzyMatch> fuzzyMatches(const string &query, int maxEdits) const {
+        string q;
+        for (char c : query) {
+            if (!isalpha(c)) continue;
+            char x = tolower(c);
+            if (x >= 'a' && x <= 'z') q.push_back(x);
+        }
+        vector<FuzzyMatch> out;
+        if (maxEdits < 0 || !ok()) return out;
+        int width = (int)q.size() + 1;
+        vector<int> rows(width);
+        for (int j = 0; j < width; j++) rows[j] = j;
+        string current;
+        fuzzyWalk(0, current, q, maxEdits, rows, out);
+        sort(out.begin(), out.end(), [](const FuzzyMatch &a, const FuzzyMatch &b) {
+            return a.distance != b.distance ? a.distance < b.distance : a.skill < b.skill;
+        });
+        return out;
+    }
+
+    vector<int> profileMatches(const string &skill) const {
+        const uint32_t *first, *last;
+        if (!postingsOf(skill, first, last)) return {};
+        return vector<int>(first, last);
+    }
+
+    // skill's profile ids in place, ascending, as [first, last); false if the
+    // skill is not in the image
+    bool postingsOf(const string &skill, const uint32_t *&first, const uint32_t *&last) const {
+        int64_t node = walk(skill);
+        return node >= 0 && postingsAt((uint32_t)node, first, last);
+    }
+
+private:
+    static constexpr uint32_t kNoSkill = UINT32_MAX;
+
+    void *base = nullptr;
+    size_t length = 0;
+    const SkillImageHeader *header = nullptr;
+    const SkillImageNode *nodes = nullptr;
+    const uint64_t *ranges = nullptr;
+    const uint32_t *ids = nullptr;
+
+    // image index of node's child for letter c, or -1
+    int64_t child(uint32_t node, int c) const {
+        const SkillImageNode &n = nodes[node];
+        if (!(n.mask >> c & 1)) return -1;
+        uint64_t idx = (uint64_t)n.firstChild + __builtin_popcount(n.mask & ((1u << c) - 1));
+        // BFS order puts children after their parent, which also rules out cycles
+        return idx > node && idx < header->nodeCount ? (int64_t)idx : -1;
+    }
+
+    // same normalisation as SkillTrie::walk
+    int64_t walk(const string &s) const {
+        if (!ok()) return -1;
+        int64_t cur = 0;
+        for (char c : s) {
+            if (!isalpha(c)) continue;
+            int idx = tolower(c) - 'a';
+            if (idx < 0 || idx >= 26) return -1;
+            cur = child((uint32_t)cur, idx);
+            if (cur < 0) return -1;
+        }
+        return cur;
+    }
+
+    // postings of the skill ending at node as [first, last); false if none
+    bool postingsAt(uint32_t node, const uint32_t *&first, const uint32_t *&last) const {
+        uint32_t k = nodes[node].skill;
+        if (k >= header->skillCount) return false;
+        uint64_t lo = ranges[k], hi = ranges[k + 1];
+        if (lo > hi || hi > header->postingCount) return false;
+        first = ids + lo;
+        last = ids + hi;
+        return true;
+    }
+
+    template <typename Fn>
+    bool visitFrom(uint32_t node, string &current, Fn &fn) const {
+        const uint32_t *first, *last;
+        if (postingsAt(node, first, last) && !fn(current, first, last)) return false;
+        for (uint32_t m = nodes[node].mask & ((1u << 26) - 1); m; m &= m - 1) {
+            int c = __builtin_ctz(m);
+            int64_t next = child(node, c);
+            if (next < 0) continue;
+            current.push_back('a' + c);
+            bool more = visitFrom((uint32_t)next, current, fn);
+            current.pop_back();
+            if (!more) return false;
+        }
+        return true;
+    }
+
+    // rows holds one DP row of width |q| + 1 per depth on the current path
+    void fuzzyWalk(uint32_t node, string &current, const string &q, int maxEdits, vector<int> &rows,
+                   vector<FuzzyMatch> &out) const {
+        int width = (int)q.size() + 1;
+        size_t depth = current.size();
+        int here = rows[depth * width + width - 1];
+        const uint32_t *first, *last;
+        if (here <= maxEdits && postingsAt(node, first, last)) out.push_back({ current, here, vector<int>(first, last) });
+        if (rows.size() < (depth + 2) * width) rows.resize((depth + 2) * width);
+        for (uint32_t m = nodes[node].mask & ((1u << 26) - 1); m; m &= m - 1) {
+            int c = __builtin_ctz(m);
+            int64_t next = child(node, c);
+            if (next < 0) continue;
+            const int *prev = &rows[depth * width]; // re-fetched: deeper calls may grow rows
+            int *cur = &rows[(depth + 1) * width];
+            cur[0] = (int)depth + 1;
+            int best = cur[0];
+            for (int j = 1; j < width; j++) {
+                int sub = prev[j - 1] + (q[j - 1] != 'a' + c);
+                cur[j] = min(sub, min(prev[j], cur[j - 1]) + 1);
+                best = min(best, cur[j]);
+            }
+            if (best > maxEdits) continue;
+            current.push_back('a' + c);
+            fuzzyWalk((uint32_t)next, current, q, maxEdits, rows, out);
+            current.pop_back();
+        }
+    }
+};
+
 // Represents a profile in Aroha Nagar (student, worker, startup).
 struct Profile {
     int id;
@@ -112,21 +1194,206 @@ public:
 
     void addProfile(const Profile &p) {
         profiles[p.id] = p;
+        allIds.add(p.id);
         for (const string &s : p.skills) {
             skillTrie.insertSkill(s, p.id);
         }
     }
 
+    // Add many profiles at once. Into an empty directory the skill trie is
+    // bulk-built (sorted, sharded by first letter across threads); otherwise
+    // this is addProfile in a loop.
+    void addProfiles(const vector<Profile> &batch) {
+        if (skillTrie.distinctSkills() > 0) {
+            for (auto &p : batch) addProfile(p);
+            return;
+        }
+        vector<pair<string, int>> links;
+        for (auto &p : batch) {
+            profiles[p.id] = p;
+            allIds.add(p.id);
+            for (const string &s : p.skills) links.emplace_back(s, p.id);
+        }
+        skillTrie = SkillTrie::bulkBuild(move(links));
+    }
+
+    // ids of profiles matching q, ascending
+    vector<int> query(const SkillQuery &q) const {
+        return matching(q).toVector();
+    }
+
+    vector<int> query(const string &text) const {
+        return query(SkillQuery::parse(text));
+    }
+
+    // a view of one stored profile, nullptr if unknown
+    const Profile *profile(int id) const {
+        auto it = profiles.find(id);
+        return it == profiles.end() ? nullptr : &it->second;
+    }
+
+    // Start from a skill index written by saveSkillIndex instead of
+    // rebuilding it: the image is mmapped and queried in place. Only for an
+    // empty directory; false if it is not empty or the file is not a
+    // readable image. The image holds skills and profile ids, not profile
+    // records: profilesWithSkill returns records only for profiles added to
+    // this directory, profileIdsWithSkill returns every id. Profiles added
+    // later are indexed in memory on top of the image and every query sees
+    // both. Prefix queries then walk the image's skills under the prefix,
+    // so the O(|prefix|) counts and cached top-k become subtree walks.
+    bool openSkillIndex(const string &path) {
+        if (!profiles.empty() || skillTrie.distinctSkills() > 0) return false;
+        auto image = make_unique<SkillTrieImage>(path);
+        if (!image->ok()) return false;
+        index = move(image);
+        return true;
+    }
+
     bool hasSkill(const string &s) {
-        return skillTrie.containsSkill(s);
+        return skillTrie.containsSkill(s) || (index && index->containsSkill(s));
     }
 
     vector<string> suggestions(const string &prefix) {
-        return skillTrie.skillsWithPrefix(prefix);
+        string key = SkillTrie::normalize(prefix);
+        if (!index) return skillTrie.skillsWithPrefix(key);
+        vector<string> all;
+        visitMerged(key, [&](string_view s, const uint32_t *, const uint32_t *, const PostingList *) {
+            all.emplace_back(s);
+            return true;
+        });
+        return all;
+    }
+
+    // ids of profiles with skill, ascending
+    vector<int> profileIdsWithSkill(const string &skill) const {
+        vector<int> live = skillTrie.profileMatches(skill);
+        const uint32_t *first, *last;
+        if (!index || !index->postingsOf(skill, first, last)) return live;
+        vector<int> all;
+        set_union(first, last, live.begin(), live.end(), back_inserter(all));
+        return all;
+    }
+
+    // one page of suggestions(prefix); deep pages cost the same as the first
+    // (with a skill index open, the page is found by walking up to it)
+    vector<string> suggestions(const string &prefix, size_t offset, size_t limit) const {
+        string key = SkillTrie::normalize(prefix);
+        if (!index) return skillTrie.skillsWithPrefix(key, offset, limit);
+        vector<string> page;
+        if (limit == 0) return page;
+        visitMerged(key, [&](string_view s, const uint32_t *, const uint32_t *, const PostingList *) {
+            if (offset > 0) {
+                offset--;
+                return true;
+            }
+            page.emplace_back(s);
+            return page.size() < limit;
+        });
+        return page;
+    }
+
+    // how many skills start with prefix, and how many (skill, profile) links
+    // they have between them, without enumerating them
+    int countSkills(const string &prefix) const {
+        string key = SkillTrie::normalize(prefix);
+        if (!index) return skillTrie.countSkillsWithPrefix(key);
+        int n = 0;
+        visitMerged(key, [&](string_view, const uint32_t *, const uint32_t *, const PostingList *) {
+            n++;
+            return true;
+        });
+        return n;
+    }
+
+    int countSkillLinks(const string &prefix) const {
+        string key = SkillTrie::normalize(prefix);
+        if (!index) return skillTrie.countLinksWithPrefix(key);
+        int n = 0;
+        visitMerged(key, [&](string_view, const uint32_t *first, const uint32_t *last, const PostingList *live) {
+            n += (int)unionSize(first, last, live);
+            return true;
+        });
+        return n;
+    }
+
+    // typo-tolerant lookup: skills (and their profiles) within maxEdits edits
+    vector<FuzzyMatch> fuzzySkills(const string &typed, int maxEdits = 2) {
+        vector<FuzzyMatch> live = skillTrie.fuzzyMatches(typed, maxEdits);
+        if (!index) return live;
+        vector<FuzzyMatch> all = index->fuzzyMatches(typed, maxEdits);
+        for (auto &m : live) {
+            auto it = find_if(all.begin(), all.end(), [&](const FuzzyMatch &x) { return x.skill == m.skill; });
+            if (it == all.end()) {
+                all.push_back(move(m));
+                continue;
+            }
+            vector<int> ids;
+            set_union(it->profiles.begin(), it->profiles.end(), m.profiles.begin(), m.profiles.end(), back_inserter(ids));
+            it->profiles = move(ids);
+        }
+        sort(all.begin(), all.end(), [](const FuzzyMatch &a, const FuzzyMatch &b) {
+            return a.distance != b.distance ? a.distance < b.distance : a.skill < b.skill;
+        });
+        return all;
+    }
+
+    // autocomplete: the k skills under prefix with the most profiles
+    vector<SkillSuggestion> topSuggestions(const string &prefix, int k) {
+        string key = SkillTrie::normalize(prefix);
+        if (!index) return skillTrie.topSkillsWithPrefix(key, k);
+        vector<SkillSuggestion> all;
+        if (k <= 0) return all;
+        visitMerged(key, [&](string_view s, const uint32_t *first, const uint32_t *last, const PostingList *live) {
+            all.push_back({ string(s), (int)unionSize(first, last, live) });
+            return true;
+        });
+        size_t keep = min(all.size(), (size_t)k);
+        partial_sort(all.begin(), all.begin() + keep, all.end(), [](const SkillSuggestion &a, const SkillSuggestion &b) {
+            return a.popularity != b.popularity ? a.popularity > b.popularity : a.skill < b.skill;
+        });
+        all.resize(keep);
+        return all;
+    }
+
+    // persist the skill index for SkillTrieImage; profiles are not included
+    bool saveSkillIndex(const string &path) const {
+        return skillTrie.writeImage(path);
+    }
+
+    // Streaming forms of suggestions / profilesWithSkill for bulk exports:
+    // results are handed to fn in order until it returns false (then these
+    // return false). Skills are views into the trie's interned names and
+    // profiles are references to the stored ones; both stay valid until the
+    // next addProfile, except views of skills found only in an open skill
+    // index, which last for the call.
+
+    // fn(string_view skill, int popularity), alphabetically
+    template <typename Fn>
+    bool visitSkills(const string &prefix, Fn fn) const {
+        string key = SkillTrie::normalize(prefix);
+        if (!index) return skillTrie.visitSkills(key, [&](string_view s, const PostingList &p) { return fn(s, (int)p.size()); });
+        return visitMerged(key, [&](string_view s, const uint32_t *first, const uint32_t *last, const PostingList *live) {
+            return fn(s, (int)unionSize(first, last, live));
+        });
+    }
+
+    // fn(const Profile &), by ascending id
+    template <typename Fn>
+    bool visitProfilesWithSkill(string_view skill, Fn fn) const {
+        auto visit = [&](int id) {
+            auto it = profiles.find(id);
+            return it == profiles.end() || fn(it->second);
+        };
+        const PostingList *p = skillTrie.postingList(skill);
+        const uint32_t *first, *last;
+        if (!index || !index->postingsOf(string(skill), first, last)) return !p || p->forEachWhile(visit);
+        PostingList ids = listOf(first, last);
+        if (p) ids = PostingList::unite(ids, *p);
+        return ids.forEachWhile(visit);
     }
 
     vector<Profile> profilesWithSkill(const string &skill) {
-        vector<int> ids = skillTrie.profileMatches(skill);
+        vector<int> ids = profileIdsWithSkill(skill);
         vector<Profile> res;
         for (int id : ids) {
             if (profiles.count(id)) {
@@ -138,13 +1405,417 @@ public:
 
 private:
     unordered_map<int, Profile> profiles;
+    PostingList allIds; // universe for queries without positive terms
     SkillTrie skillTrie;
+    unique_ptr<SkillTrieImage> index; // mapped skill index from openSkillIndex, if any
+
+    // the image's ids [first, last) as a PostingList
+    static PostingList listOf(const uint32_t *first, const uint32_t *last) {
+        PostingList out;
+        for (const uint32_t *id = first; id != last; id++) out.add((int)*id);
+        return out;
+    }
+
+    // size of [first, last) united with live, without building the union
+    static size_t unionSize(const uint32_t *first, const uint32_t *last, const PostingList *live) {
+        size_t n = last - first;
+        if (!live) return n;
+        n += live->size();
+        for (const uint32_t *id = first; id != last; id++) n -= live->contains((int)*id);
+        return n;
+    }
+
+    // fn(skill, first, last, live) for each skill under key in the index or
+    // in memory, alphabetically, until fn returns false; false if it did.
+    // [first, last) are the image's ids (empty if it lacks the skill), live
+    // the in-memory list or nullptr. Needs an open index.
+    template <typename Fn>
+    bool visitMerged(const string &key, Fn fn) const {
+        vector<pair<string_view, const PostingList *>> live;
+        skillTrie.visitSkills(key, [&](string_view s, const PostingList &p) {
+            live.emplace_back(s, &p);
+            return true;
+        });
+        size_t i = 0;
+        bool more = index->visitSkills(key, [&](const string &skill, const uint32_t *first, const uint32_t *last) {
+            for (; i < live.size() && live[i].first < skill; i++)
+                if (!fn(live[i].first, nullptr, nullptr, live[i].second)) return false;
+            const PostingList *both = nullptr;
+            if (i < live.size() && live[i].first == skill) both = live[i++].second;
+            return fn(string_view(skill), first, last, both);
+        });
+        if (!more) return false;
+        for (; i < live.size(); i++)
+            if (!fn(live[i].first, nullptr, nullptr, live[i].second)) return false;
+        return true;
+    }
+
+    // s's ids from memory and the index; when the index has s, the merged
+    // list is kept in scratch. nullptr if neither has it
+    const PostingList *termList(const string &s, deque<PostingList> &scratch) const {
+        const PostingList *live = skillTrie.postingList(s);
+        const uint32_t *first, *last;
+        if (!index || !index->postingsOf(s, first, last)) return live;
+        scratch.push_back(listOf(first, last));
+        if (live) scratch.back() = PostingList::unite(scratch.back(), *live);
+        return &scratch.back();
+    }
+
+    PostingList matching(const SkillQuery &q) const {
+        deque<PostingList> scratch; // merged term lists; a deque keeps them in place
+        vector<const PostingList *> must;
+        for (auto &s : q.allOf) {
+            const PostingList *p = termList(s, scratch);
+            if (!p) return PostingList();
+            must.push_back(p);
+        }
+        // smallest first keeps every intermediate result small
+        sort(must.begin(), must.end(), [](const PostingList *a, const PostingList *b) { return a->size() < b->size(); });
+        PostingList acc;
+        const PostingList *cur = nullptr; // acc, or a stored list that need not be copied yet
+        for (const PostingList *p : must) {
+            if (cur) {
+                acc = PostingList::intersect(*cur, *p);
+                cur = &acc;
+            } else {
+                cur = p;
+            }
+            if (cur->empty()) return PostingList();
+        }
+        for (auto &group : q.anyOf) {
+            PostingList any;
+            for (auto &s : group)
+                if (const PostingList *p = termList(s, scratch)) any = PostingList::unite(any, *p);
+            acc = cur ? PostingList::intersect(*cur, any) : move(any);
+            cur = &acc;
+        }
+        if (!cur && index) {
+            // no positive terms: start from every id, the image's included
+            scratch.push_back(allIds);
+            index->visitSkills("", [&](const string &, const uint32_t *first, const uint32_t *last) {
+                for (const uint32_t *id = first; id != last; id++) scratch.back().add((int)*id);
+                return true;
+            });
+            cur = &scratch.back();
+        }
+        if (!cur) cur = &allIds;
+        for (auto &s : q.noneOf) {
+            if (const PostingList *p = termList(s, scratch)) {
+                acc = PostingList::subtract(*cur, *p);
+                cur = &acc;
+            }
+        }
+        return cur == &acc ? acc : *cur;
+    }
+};
+
+// Persistent (path-copying) skill trie for lock-free readers. A writer never
+// touches a published node: it copies the path it changes, then publishes the
+// new root with one atomic store. Readers pin a Snapshot and query it without
+// locks. Replaced nodes are freed once no reader that could still see them is
+// active (epoch-based reclamation). Writes are serialised internally.
+class PersistentSkillTrie {
+public:
+    // posting lists are shared between versions: new ids are prepended, and
+    // a (skill, profile) link is only ever added once
+    struct Posting {
+        int profileId;
+        const Profile *profile;
+        const Posting *next;
+    };
+
+    struct Node {
+        uint32_t mask = 0;     // bit i set: child for 'a' + i
+        bool isEnd = false;
+        int wordCount = 0;
+        int postingCount = 0;
+        const Posting *postings = nullptr; // newest first
+        uint32_t skill = 0;    // slot in the writer's linked sets, valid when isEnd
+        uint64_t txn = 0;      // write that created the node; only that write may modify it
+        vector<Node *> kids;   // one per set bit of mask, in letter order
+
+        int rank(int i) const { return __builtin_popcount(mask & ((1u << i) - 1)); }
+        Node *child(int i) const { return (mask >> i & 1) ? kids[rank(i)] : nullptr; }
+    };
+
+private:
+    struct ReaderSlot;
+
+public:
+    // A stable view of the trie as of construction; hold it only briefly, it
+    // delays reclamation of everything replaced meanwhile. Readers beyond
+    // the kReaderSlots slots never wait: they register in a shared overflow
+    // count instead, and reclamation pauses while that is non-zero.
+    class Snapshot {
+    public:
+        explicit Snapshot(const PersistentSkillTrie &trie) {
+            static thread_local unsigned hint = (unsigned)hash<thread::id>()(this_thread::get_id());
+            for (unsigned i = hint; i < hint + kReaderSlots; i++) {
+                ReaderSlot &s = trie.readers[i % kReaderSlots];
+                uint64_t idle = kIdle;
+                if (s.epoch.compare_exchange_strong(idle, trie.epoch.load())) {
+                    slot = &s;
+                    hint = i;
+                    break;
+                }
+            }
+            if (!slot) {
+                overflow = &trie.overflowReaders;
+                overflow->fetch_add(1);
+            }
+            root = trie.root.load();
+        }
+
+        ~Snapshot() {
+            if (slot) slot->epoch.store(kIdle, memory_order_release);
+            else overflow->fetch_sub(1, memory_order_release);
+        }
+
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        bool containsSkill(const string &skill) const {
+            const Node *n = walk(skill);
+            return n && n->isEnd;
+        }
+
+        vector<string> skillsWithPrefix(const string &prefix) const {
+            vector<string> result;
+            const Node *n = walk(prefix);
+            if (!n) return result;
+            string current = prefix;
+            explore(n, current, result);
+            return result;
+        }
+
+        // number of profiles linked to skill
+        int popularity(const string &skill) const {
+            const Node *n = walk(skill);
+            return n && n->isEnd ? n->postingCount : 0;
+        }
+
+        // profile ids, ascending (as SkillTrie)
+        vector<int> profileMatches(const string &skill) const {
+            vector<int> ids;
+            forEachPosting(skill, [&](const Posting &p) { ids.push_back(p.profileId); });
+            sort(ids.begin(), ids.end());
+            return ids;
+        }
+
+        // profiles linked to skill, by ascending id; valid while the trie lives
+        vector<const Profile *> profiles(const string &skill) const {
+            vector<const Posting *> links;
+            forEachPosting(skill, [&](const Posting &p) { links.push_back(&p); });
+            sort(links.begin(), links.end(), [](const Posting *a, const Posting *b) { return a->profileId < b->profileId; });
+            vector<const Profile *> out;
+            for (const Posting *p : links) out.push_back(p->profile);
+            return out;
+        }
+
+    private:
+        ReaderSlot *slot = nullptr;
+        atomic<uint64_t> *overflow = nullptr; // set instead of slot when all slots were busy
+        const Node *root = nullptr;
+
+        const Node *walk(const string &s) const { return find(root, s); }
+
+        template <typename Fn>
+        void forEachPosting(const string &skill, Fn fn) const {
+            const Node *n = walk(skill);
+            if (!n || !n->isEnd) return;
+            for (const Posting *p = n->postings; p; p = p->next) fn(*p);
+        }
+
+        void explore(const Node *n, string &current, vector<string> &out) const {
+            if (n->isEnd) out.push_back(current);
+            for (int i = 0; i < 26; i++) {
+                if (!(n->mask >> i & 1)) continue;
+                current.push_back('a' + i);
+                explore(n->kids[n->rank(i)], current, out);
+                current.pop_back();
+            }
+        }
+    };
+
+    PersistentSkillTrie() {
+        root.store(new Node());
+    }
+
+    ~PersistentSkillTrie() {
+        for (auto &batch : retired)
+            for (Node *n : batch.nodes) delete n;
+        destroy(root.load());
+    }
+
+    PersistentSkillTrie(const PersistentSkillTrie &) = delete;
+    PersistentSkillTrie &operator=(const PersistentSkillTrie &) = delete;
+
+    // all skills of one profile become visible together, as one new version
+    void insertSkills(const vector<string> &skills, int profileId, const Profile *profile) {
+        lock_guard<mutex> lk(writeMu);
+        txn++;
+        Node *newRoot = writable(root.load(memory_order_relaxed));
+        for (const string &skill : skills) insertPath(newRoot, skill, profileId, profile);
+        publish(newRoot);
+    }
+
+    Snapshot snapshot() const { return Snapshot(*this); }
+
+    size_t pendingReclaim() const {
+        lock_guard<mutex> lk(writeMu);
+        size_t n = 0;
+        for (auto &batch : retired) n += batch.nodes.size();
+        return n;
+    }
+
+private:
+    static constexpr int kReaderSlots = 64;
+    static constexpr uint64_t kIdle = UINT64_MAX;
+
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch{kIdle}; // epoch seen when the snapshot was pinned
+    };
+
+    struct RetiredBatch {
+        uint64_t epoch;
+        vector<Node *> nodes;
+    };
+
+    // node reached from n by s, or nullptr; same normalisation as SkillTrie
+    static const Node *find(const Node *n, const string &s) {
+        for (char c : s) {
+            if (!isalpha(c)) continue;
+            int idx = tolower(c) - 'a';
+            if (idx < 0 || idx >= 26) return nullptr;
+            n = n->child(idx);
+            if (!n) return nullptr;
+        }
+        return n;
+    }
+
+    atomic<Node *> root{nullptr};
+    atomic<uint64_t> epoch{0};
+    mutable array<ReaderSlot, kReaderSlots> readers;
+    mutable atomic<uint64_t> overflowReaders{0}; // active snapshots without a slot
+    mutable mutex writeMu;
+    uint64_t txn = 0;
+    vector<Node *> replaced;       // nodes copied during the current write
+    deque<RetiredBatch> retired;   // oldest first
+    vector<PostingList> linked;    // writer-side: profile ids per skill slot, for duplicate checks
+
+    // a node this write may modify: n itself if the write created it, else a copy
+    Node *writable(Node *n) {
+        if (n->txn == txn) return n;
+        Node *copy = new Node(*n);
+        copy->txn = txn;
+        replaced.push_back(n);
+        return copy;
+    }
+
+    void insertPath(Node *cur, const string &skill, int profileId, const Profile *profile) {
+        // a link that already exists (in this write or an earlier one) changes nothing
+        if (const Node *n = find(cur, skill); n && n->isEnd && linked[n->skill].contains(profileId)) return;
+        for (char c : skill) {
+            if (isalpha(c) == false) continue;
+            int idx = tolower(c) - 'a';
+            if (idx < 0 || idx >= 26) continue;
+            Node *next = cur->child(idx);
+            if (!next) {
+                next = new Node();
+                next->txn = txn;
+                cur->kids.insert(cur->kids.begin() + cur->rank(idx), next);
+                cur->mask |= 1u << idx;
+            } else {
+                Node *w = writable(next);
+                if (w != next) cur->kids[cur->rank(idx)] = w;
+                next = w;
+            }
+            next->wordCount++;
+            cur = next;
+        }
+        if (!cur->isEnd) {
+            cur->isEnd = true;
+            cur->skill = (uint32_t)linked.size();
+            linked.emplace_back();
+        }
+        linked[cur->skill].add(profileId);
+        cur->postings = new Posting{ profileId, profile, cur->postings };
+        cur->postingCount++;
+    }
+
+    void publish(Node *newRoot) {
+        root.store(newRoot);
+        uint64_t e = epoch.fetch_add(1);
+        if (!replaced.empty()) retired.push_back({ e, move(replaced) });
+        replaced.clear();
+
+        // a reader pinned at epoch r may hold nodes retired at epochs >= r;
+        // an overflow reader's epoch is unknown, so it pins everything
+        if (overflowReaders.load() > 0) return;
+        uint64_t oldest = kIdle;
+        for (auto &s : readers) oldest = min(oldest, s.epoch.load());
+        while (!retired.empty() && retired.front().epoch < oldest) {
+            for (Node *n : retired.front().nodes) delete n;
+            retired.pop_front();
+        }
+    }
+
+    // frees the live version: its nodes and every posting (all postings are
+    // reachable from the newest lists)
+    static void destroy(Node *n) {
+        for (Node *k : n->kids) destroy(k);
+        for (const Posting *p = n->postings; p;) {
+            const Posting *next = p->next;
+            delete p;
+            p = next;
+        }
+        delete n;
+    }
+};
+
+// SkillDirectory for concurrent use: one ingesting writer at a time and any
+// number of lock-free readers, each query answered from one snapshot.
+class ConcurrentSkillDirectory {
+public:
+    void addProfile(const Profile &p) {
+        const Profile *stored;
+        {
+            lock_guard<mutex> lk(profilesMu);
+            profiles.push_back(p); // deque: earlier profiles never move
+            stored = &profiles.back();
+        }
+        skillTrie.insertSkills(p.skills, p.id, stored);
+    }
+
+    bool hasSkill(const string &s) const {
+        return skillTrie.snapshot().containsSkill(s);
+    }
+
+    vector<string> suggestions(const string &prefix) const {
+        return skillTrie.snapshot().skillsWithPrefix(prefix);
+    }
+
+    vector<Profile> profilesWithSkill(const string &skill) const {
+        vector<Profile> res;
+        for (const Profile *p : skillTrie.snapshot().profiles(skill)) res.push_back(*p);
+        return res;
+    }
+
+    // several queries against the same version of the directory
+    PersistentSkillTrie::Snapshot snapshot() const { return skillTrie.snapshot(); }
+
+private:
+    mutex profilesMu;
+    deque<Profile> profiles;
+    PersistentSkillTrie skillTrie;
 };
 
 // Simulates real-time updates where new skills are registered over time.
+// Works with SkillDirectory or ConcurrentSkillDirectory.
+template <typename Directory>
 class SkillStreamSimulator {
 public:
-    SkillStreamSimulator(SkillDirectory &dir, vector<Profile> baseData)
+    SkillStreamSimulator(Directory &dir, vector<Profile> baseData)
         : directory(dir), data(move(baseData)) { }
 
     void streamUpdates(int intervalMs, int cycles) {
@@ -158,10 +1829,480 @@ public:
     }
 
 private:
-    SkillDirectory &directory;
+    Directory &directory;
     vector<Profile> data;
 };
 
+// Synthetic directory for benchmarks: `vocab` distinct lowercase skill words,
+// each profile draws 3-8 of them, skewed towards the front of the vocabulary.
+// Profiles are handed to fn one at a time in a reused object.
+template <typename Fn>
+void forEachSyntheticProfile(int count, int vocab, unsigned seed, Fn fn) {
+    mt19937 rng(seed);
+    unordered_set<string> seen;
+    vector<string> words;
+    uniform_int_distribution<int> len(3, 12), letter(0, 25);
+    while ((int)words.size() < vocab) {
+        string w;
+        int n = len(rng);
+        for (int i = 0; i < n; i++) w.push_back('a' + letter(rng));
+        if (seen.insert(w).second) words.push_back(w);
+    }
+    uniform_real_distribution<double> u(0.0, 1.0);
+    uniform_int_distribution<int> perProfile(3, 8);
+    Profile p;
+    for (int i = 0; i < count; i++) {
+        p.id = i + 1;
+        p.name = "p" + to_string(i + 1);
+        p.skills.clear();
+        int k = perProfile(rng);
+        for (int j = 0; j < k; j++) {
+            double x = u(rng);
+            p.skills.push_back(words[(size_t)(x * x * x * vocab)]);
+        }
+        fn(p);
+    }
+}
+
+vector<Profile> syntheticProfiles(int count, int vocab, unsigned seed = 42) {
+    vector<Profile> out;
+    out.reserve(count);
+    forEachSyntheticProfile(count, vocab, seed, [&](const Profile &p) { out.push_back(p); });
+    return out;
+}
+
+// Pooled SkillTrie vs the pointer-per-node layout it replaced.
+void benchMemory(int profileCount, int vocab) {
+    vector<Profile> data = syntheticProfiles(profileCount, vocab);
+    SkillTrie trie;
+    size_t links = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (auto &p : data) {
+        for (auto &s : p.skills) trie.insertSkill(s, p.id);
+        links += p.skills.size();
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    double skills = (double)trie.distinctSkills();
+    cout << profileCount << " profiles, " << links << " skill links, " << trie.distinctSkills()
+         << " distinct skills, " << trie.nodeCount() << " nodes, built in " << ms << " ms\n";
+    cout << "  pointer nodes : " << trie.pointerLayoutBytes() / skills << " bytes/skill ("
+         << sizeof(PointerSkillNode) << " B/node, excluding allocator headers)\n";
+    cout << "  pooled nodes  : " << trie.memoryBytes() / skills << " bytes/skill ("
+         << sizeof(SkillNode) << " B/node)\n";
+}
+
+// Per-keystroke cost of full enumeration + ranking vs the cached top-K.
+void benchTopK(int profileCount, int vocab, int k) {
+    vector<Profile> data = syntheticProfiles(profileCount, vocab);
+    SkillTrie trie;
+    for (auto &p : data) for (auto &s : p.skills) trie.insertSkill(s, p.id);
+
+    vector<string> prefixes;
+    for (char a = 'a'; a <= 'z'; a++) prefixes.push_back(string(1, a));
+    auto ms = [](auto d) { return chrono::duration<double, milli>(d).count(); };
+
+    auto t0 = chrono::steady_clock::now();
+    size_t sink = 0;
+    for (auto &p : prefixes) {
+        vector<string> all = trie.skillsWithPrefix(p);
+        vector<pair<int, string>> ranked;
+        for (auto &s : all) ranked.push_back({ (int)trie.profileMatches(s).size(), s });
+        partial_sort(ranked.begin(), ranked.begin() + min<size_t>(k, ranked.size()), ranked.end(), greater<>());
+        sink += ranked.size();
+    }
+    auto t1 = chrono::steady_clock::now();
+    for (int rep = 0; rep < 1000; rep++)
+        for (auto &p : prefixes) sink += trie.topSkillsWithPrefix(p, k).size();
+    auto t2 = chrono::steady_clock::now();
+
+    cout << trie.distinctSkills() << " skills, top-" << k << " for each one-letter prefix\n";
+    cout << "  enumerate + rank : " << 1e3 * ms(t1 - t0) / prefixes.size() << " us/query\n";
+    cout << "  cached top-K     : " << 1e3 * ms(t2 - t1) / (1000.0 * prefixes.size()) << " us/query"
+         << "  (cache " << trie.suggestionCacheBytes() / (1 << 20) << " MiB)  [" << sink % 10 << "]\n";
+}
+
+// Trie-walking fuzzy lookup vs edit distance against every skill.
+void benchFuzzy(int profileCount, int vocab, int queries) {
+    vector<Profile> data = syntheticProfiles(profileCount, vocab);
+    SkillTrie trie;
+    vector<string> skills;
+    for (auto &p : data) for (auto &s : p.skills) trie.insertSkill(s, p.id);
+    for (auto &s : trie.skillsWithPrefix("")) skills.push_back(s);
+
+    // queries: real skills with one or two random edits
+    mt19937 rng(11);
+    vector<string> typed;
+    for (int i = 0; i < queries; i++) {
+        string s = skills[rng() % skills.size()];
+        for (int e = 1 + rng() % 2; e > 0 && !s.empty(); e--) {
+            size_t at = rng() % s.size();
+            switch (rng() % 3) {
+            case 0: s[at] = 'a' + rng() % 26; break;
+            case 1: s.erase(at, 1); break;
+            default: s.insert(s.begin() + at, (char)('a' + rng() % 26));
+            }
+        }
+        typed.push_back(s);
+    }
+
+    auto editDistance = [](const string &a, const string &b) {
+        vector<int> row(b.size() + 1);
+        iota(row.begin(), row.end(), 0);
+        for (size_t i = 1; i <= a.size(); i++) {
+            int diag = row[0];
+            row[0] = (int)i;
+            for (size_t j = 1; j <= b.size(); j++) {
+                int up = row[j];
+                row[j] = min(diag + (a[i - 1] != b[j - 1]), min(up, row[j - 1]) + 1);
+                diag = up;
+            }
+        }
+        return row[b.size()];
+    };
+
+    auto ms = [](auto d) { return chrono::duration<double, milli>(d).count(); };
+    auto t0 = chrono::steady_clock::now();
+    size_t trieHits = 0;
+    for (auto &q : typed) trieHits += trie.fuzzyMatches(q, 2).size();
+    auto t1 = chrono::steady_clock::now();
+    size_t bruteHits = 0;
+    for (auto &q : typed) for (auto &s : skills) bruteHits += editDistance(q, s) <= 2;
+    auto t2 = chrono::steady_clock::now();
+
+    cout << skills.size() << " skills, " << queries << " queries with 1-2 typos, k = 2\n";
+    cout << "  trie walk   : " << 1e3 * ms(t1 - t0) / queries << " us/query, " << trieHits << " matches\n";
+    cout << "  brute force : " << 1e3 * ms(t2 - t1) / queries << " us/query, " << bruteHits << " matches\n";
+}
+
+// Read throughput of ConcurrentSkillDirectory with 1..N reader threads while
+// a writer keeps ingesting synthetic profiles.
+void benchConcurrent(int profileCount, int vocab, int maxReaders) {
+    vector<Profile> data = syntheticProfiles(profileCount, vocab);
+    vector<string> probes;
+    for (size_t i = 0; i < data.size(); i += 7) probes.push_back(data[i].skills[0]);
+
+    for (int readers = 1; readers <= maxReaders; readers *= 2) {
+        ConcurrentSkillDirectory directory;
+        for (size_t i = 0; i < data.size() / 2; i++) directory.addProfile(data[i]); // warm start
+        atomic<bool> stop{false};
+        atomic<uint64_t> reads{0};
+        size_t ingested = 0;
+
+        thread writer([&]() {
+            for (size_t i = data.size() / 2; i < data.size() && !stop.load(); i++, ingested++) directory.addProfile(data[i]);
+        });
+        vector<thread> pool;
+        for (int r = 0; r < readers; r++) {
+            pool.emplace_back([&, r]() {
+                uint64_t n = 0;
+                size_t k = r * 7919;
+                while (!stop.load(memory_order_relaxed)) {
+                    const string &s = probes[k++ % probes.size()];
+                    auto snap = directory.snapshot();
+                    if (snap.containsSkill(s)) n += snap.popularity(s) > 0;
+                }
+                reads += n;
+            });
+        }
+        this_thread::sleep_for(chrono::milliseconds(1000));
+        stop.store(true);
+        writer.join();
+        for (auto &t : pool) t.join();
+        cout << "  readers=" << readers << ": " << reads.load() / 1e6 << " M reads/s, "
+             << ingested << " profiles ingested meanwhile\n";
+    }
+}
+
+// Startup from scratch vs from a mapped image: build time, image write and
+// open time, and lookups through the image checked against the live trie and
+// through a half-image directory checked against an all-in-memory one.
+void benchImage(int profileCount, int vocab, const string &path) {
+    vector<Profile> data = syntheticProfiles(profileCount, vocab);
+    auto ms = [](auto d) { return chrono::duration<double, milli>(d).count(); };
+    auto t0 = chrono::steady_clock::now();
+    SkillTrie trie;
+    for (auto &p : data)
+        for (auto &s : p.skills) trie.insertSkill(s, p.id);
+    auto t1 = chrono::steady_clock::now();
+    if (!trie.writeImage(path)) {
+        cerr << "Cannot write image " << path << "\n";
+        return;
+    }
+    auto t2 = chrono::steady_clock::now();
+    SkillTrieImage image(path);
+    auto t3 = chrono::steady_clock::now();
+    if (!image.ok()) {
+        cerr << "Not a readable skill image: " << path << "\n";
+        return;
+    }
+
+    vector<string> skills = trie.skillsWithPrefix("");
+    size_t bad = 0, links = 0;
+    auto t4 = chrono::steady_clock::now();
+    for (auto &s : skills) {
+        const uint32_t *first, *last;
+        if (!image.postingsOf(s, first, last)) { bad++; continue; }
+        links += last - first;
+    }
+    auto t5 = chrono::steady_clock::now();
+    for (auto &s : skills) bad += image.profileMatches(s) != trie.profileMatches(s);
+    for (char a = 'a'; a <= 'z'; a++)
+        for (char b = 'a'; b <= 'z'; b++) {
+            string prefix{ a, b };
+            bad += image.skillsWithPrefix(prefix) != trie.skillsWithPrefix(prefix);
+        }
+
+    // the same answers from a directory started on the image
+    auto t6 = chrono::steady_clock::now();
+    SkillDirectory directory;
+    bool opened = directory.openSkillIndex(path);
+    auto t7 = chrono::steady_clock::now();
+    bad += !opened;
+    for (size_t i = 0; opened && i < skills.size(); i += 97)
+        bad += !directory.hasSkill(skills[i]) || directory.profileIdsWithSkill(skills[i]) != trie.profileMatches(skills[i]);
+    bad += opened && directory.suggestions("ab") != trie.skillsWithPrefix("ab");
+
+    // an image of the first half with the rest added on top answers like a
+    // directory that holds everything in memory
+    string halfPath = path + ".half";
+    size_t half = data.size() / 2;
+    SkillTrie firstHalf;
+    for (size_t i = 0; i < half; i++)
+        for (auto &s : data[i].skills) firstHalf.insertSkill(s, data[i].id);
+    SkillDirectory layered, whole;
+    bad += !firstHalf.writeImage(halfPath) || !layered.openSkillIndex(halfPath);
+    for (size_t i = half; i < data.size(); i++) layered.addProfile(data[i]);
+    whole.addProfiles(data);
+    auto sameTop = [](const vector<SkillSuggestion> &a, const vector<SkillSuggestion> &b) {
+        return equal(a.begin(), a.end(), b.begin(), b.end(), [](const SkillSuggestion &x, const SkillSuggestion &y) {
+            return x.skill == y.skill && x.popularity == y.popularity;
+        });
+    };
+    for (const char *prefix : { "", "a", "Ab", "qU", "zzz" }) {
+        bad += layered.countSkills(prefix) != whole.countSkills(prefix);
+        bad += layered.countSkillLinks(prefix) != whole.countSkillLinks(prefix);
+        bad += layered.suggestions(prefix, 0, 20) != whole.suggestions(prefix, 0, 20);
+        bad += layered.suggestions(prefix, 500, 20) != whole.suggestions(prefix, 500, 20);
+        bad += !sameTop(layered.topSuggestions(prefix, 5), whole.topSuggestions(prefix, 5));
+    }
+    bad += layered.suggestions("Ab") != whole.suggestions("Ab");
+    for (size_t i = 0; i + 1 < skills.size() && i < 2000; i += 401) {
+        const string &x = skills[i], &y = skills[i + 1];
+        for (string q : { x + " AND NOT " + y, "(" + x + " OR " + y + ")", "NOT " + x })
+            bad += layered.query(q) != whole.query(q);
+        string typo = x.substr(1);
+        auto a = layered.fuzzySkills(typo, 1), b = whole.fuzzySkills(typo, 1);
+        bad += a.size() != b.size();
+        for (size_t k = 0; k < min(a.size(), b.size()); k++)
+            bad += a[k].skill != b[k].skill || a[k].distance != b[k].distance || a[k].profiles != b[k].profiles;
+    }
+
+    cout << profileCount << " profiles, " << image.distinctSkills() << " skills, " << links << " links, "
+         << image.nodeCount() << " nodes\n";
+    cout << "  incremental build : " << ms(t1 - t0) << " ms\n";
+    cout << "  write image       : " << ms(t2 - t1) << " ms, " << image.fileBytes() / (1 << 20) << " MiB\n";
+    cout << "  open image        : " << ms(t3 - t2) << " ms (SkillDirectory::openSkillIndex " << ms(t7 - t6) << " ms)\n";
+    cout << "  postings lookups  : " << 1e6 * ms(t5 - t4) / skills.size() << " ns/skill from the mapping\n";
+    cout << "  mismatches vs trie: " << bad << " (image, opened and layered directory)\n";
+    remove(path.c_str());
+    remove(halfPath.c_str());
+}
+
+// Incremental insertSkill vs bulkBuild on the same links. Each build runs in
+// a forked child so its peak RSS can be read back with wait4; a child that
+// only generates the links gives the baseline.
+void benchBulk(int profileCount, int vocab) {
+    auto run = [&](const char *label, int mode) {
+        cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            vector<pair<string, int>> links;
+            forEachSyntheticProfile(profileCount, vocab, 42, [&](const Profile &p) {
+                for (auto &s : p.skills) links.emplace_back(s, p.id);
+            });
+            size_t linkCount = links.size();
+            auto t0 = chrono::steady_clock::now();
+            SkillTrie trie;
+            if (mode == 1) {
+                for (auto &l : links) trie.insertSkill(l.first, l.second);
+            } else if (mode == 2) {
+                trie = SkillTrie::bulkBuild(move(links));
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+            size_t check = 0;
+            for (char c = 'a' - 1; c <= 'z'; c++) // "" and every letter, served from the caches
+                for (auto &s : trie.topSkillsWithPrefix(c < 'a' ? "" : string(1, c), SkillTrie::kTopK))
+                    check = check * 31 + hash<string>()(s.skill) + s.popularity;
+            printf("  %-18s: %9.1f ms, %zu links, %zu skills, %zu nodes, check %zx", label, ms, linkCount, trie.distinctSkills(), trie.nodeCount(), check);
+            fflush(stdout);
+            _exit(0);
+        }
+        int status;
+        struct rusage ru;
+        if (pid < 0 || wait4(pid, &status, 0, &ru) < 0) return;
+        printf(", peak RSS %ld MiB\n", ru.ru_maxrss / 1024);
+    };
+    // both builds must answer every query the same, suggestion caches included
+    {
+        vector<pair<string, int>> links;
+        forEachSyntheticProfile(min(profileCount, 50000), vocab / 10, 7, [&](const Profile &p) {
+            for (auto &s : p.skills) links.emplace_back(s, p.id);
+        });
+        SkillTrie incremental;
+        for (auto &l : links) incremental.insertSkill(l.first, l.second);
+        SkillTrie bulk = SkillTrie::bulkBuild(links);
+        size_t bad = 0, checked = 0;
+        auto same = [&](const string &prefix) {
+            for (int k = 1; k <= SkillTrie::kTopK + 4; k++) {
+                auto a = incremental.topSkillsWithPrefix(prefix, k), b = bulk.topSkillsWithPrefix(prefix, k);
+                bool equal = a.size() == b.size();
+                for (size_t i = 0; equal && i < a.size(); i++) equal = a[i].skill == b[i].skill && a[i].popularity == b[i].popularity;
+                bad += !equal;
+                checked++;
+            }
+            bad += incremental.countLinksWithPrefix(prefix) != bulk.countLinksWithPrefix(prefix);
+            bad += incremental.countSkillsWithPrefix(prefix) != bulk.countSkillsWithPrefix(prefix);
+        };
+        same("");
+        for (char a = 'a'; a <= 'z'; a++) {
+            same(string(1, a));
+            for (char b = 'a'; b <= 'z'; b++) same(string{ a, b });
+        }
+        for (auto &s : incremental.skillsWithPrefix("")) bad += incremental.profileMatches(s) != bulk.profileMatches(s);
+        cout << "cross-check on " << links.size() << " links: " << checked << " top-k queries, " << bad << " mismatches\n";
+    }
+
+    cout << profileCount << " profiles, " << max(1u, thread::hardware_concurrency()) << " hardware threads\n";
+    run("links only", 0);
+    run("insertSkill", 1);
+    run("bulkBuild", 2);
+}
+
+// Export every (skill, profile) pair through the copying API and through the
+// visitors, plus an early-terminated "first 10 profiles per skill" pass.
+void benchVisit(int profileCount, int vocab) {
+    SkillDirectory directory;
+    directory.addProfiles(syntheticProfiles(profileCount, vocab));
+    auto ms = [](auto d) { return chrono::duration<double, milli>(d).count(); };
+
+    auto t0 = chrono::steady_clock::now();
+    size_t a = 0;
+    for (auto &s : directory.suggestions(""))
+        for (auto &p : directory.profilesWithSkill(s)) a += s.size() + p.name.size();
+    auto t1 = chrono::steady_clock::now();
+    size_t b = 0, pairs = 0;
+    directory.visitSkills("", [&](string_view s, int) {
+        return directory.visitProfilesWithSkill(s, [&](const Profile &p) {
+            b += s.size() + p.name.size();
+            pairs++;
+            return true;
+        });
+    });
+    auto t2 = chrono::steady_clock::now();
+    size_t firstTen = 0;
+    directory.visitSkills("", [&](string_view s, int) {
+        int left = 10;
+        directory.visitProfilesWithSkill(s, [&](const Profile &) {
+            firstTen++;
+            return --left > 0;
+        });
+        return true;
+    });
+    auto t3 = chrono::steady_clock::now();
+
+    cout << profileCount << " profiles, " << pairs << " (skill, profile) pairs\n";
+    cout << "  suggestions + profilesWithSkill : " << ms(t1 - t0) << " ms (checksum " << a << ")\n";
+    cout << "  visitSkills + visitProfiles     : " << ms(t2 - t1) << " ms (checksum " << b << ")\n";
+    cout << "  first 10 profiles per skill     : " << ms(t3 - t2) << " ms, " << firstTen << " visited\n";
+}
+
+// Prefix counts and pages from the per-node counters vs enumerating the whole
+// prefix and slicing it.
+void benchPaging(int profileCount, int vocab, int pageSize) {
+    SkillDirectory directory;
+    directory.addProfiles(syntheticProfiles(profileCount, vocab));
+    auto us = [](auto d) { return chrono::duration<double, micro>(d).count(); };
+    const int reps = 20;
+    for (string prefix : { "", "s", "st" }) {
+        int total = directory.countSkills(prefix);
+        auto t0 = chrono::steady_clock::now();
+        size_t enumerated = 0;
+        for (int r = 0; r < reps; r++) enumerated += directory.suggestions(prefix).size();
+        auto t1 = chrono::steady_clock::now();
+        int counted = 0;
+        for (int r = 0; r < reps; r++) counted += directory.countSkills(prefix);
+        auto t2 = chrono::steady_clock::now();
+        cout << "prefix '" << prefix << "': " << total << " skills, " << directory.countSkillLinks(prefix)
+             << " links; count by enumeration " << us(t1 - t0) / reps << " us, from counters "
+             << us(t2 - t1) / reps << " us" << (enumerated == (size_t)counted ? "" : " MISMATCH") << "\n";
+        for (size_t offset : { (size_t)0, (size_t)total / 2, (size_t)max(0, total - pageSize) }) {
+            auto t3 = chrono::steady_clock::now();
+            vector<string> full, page;
+            for (int r = 0; r < reps; r++) {
+                full = directory.suggestions(prefix);
+                full.erase(full.begin(), full.begin() + min(offset, full.size()));
+                full.resize(min(full.size(), (size_t)pageSize));
+            }
+            auto t4 = chrono::steady_clock::now();
+            for (int r = 0; r < reps; r++) page = directory.suggestions(prefix, offset, pageSize);
+            auto t5 = chrono::steady_clock::now();
+            cout << "  page at offset " << offset << ": slice " << us(t4 - t3) / reps << " us, paged "
+                 << us(t5 - t4) / reps << " us" << (full == page ? "" : " MISMATCH") << "\n";
+        }
+    }
+}
+
+// "A AND B AND NOT C" over popular skills: PostingList queries vs the same
+// work on sorted vector<int> posting lists.
+void benchQuery(int profileCount, int vocab, int queries) {
+    vector<Profile> data = syntheticProfiles(profileCount, vocab);
+    SkillDirectory directory;
+    SkillTrie trie;
+    for (auto &p : data) {
+        directory.addProfile(p);
+        for (auto &s : p.skills) trie.insertSkill(s, p.id);
+    }
+    vector<SkillSuggestion> popular = trie.topSkillsWithPrefix("", 200);
+
+    size_t vectorBytes = 0, listBytes = 0;
+    unordered_map<string, vector<int>> sorted;
+    for (auto &s : popular) {
+        sorted[s.skill] = trie.profileMatches(s.skill);
+        vectorBytes += sorted[s.skill].size() * sizeof(int);
+        listBytes += trie.postingList(s.skill)->memoryBytes();
+    }
+
+    mt19937 rng(13);
+    vector<SkillQuery> qs;
+    for (int i = 0; i < queries; i++) {
+        SkillQuery q;
+        q.allOf = { popular[rng() % popular.size()].skill, popular[rng() % popular.size()].skill };
+        q.noneOf = { popular[rng() % 50].skill };
+        qs.push_back(q);
+    }
+
+    auto ms = [](auto d) { return chrono::duration<double, milli>(d).count(); };
+    auto t0 = chrono::steady_clock::now();
+    size_t a = 0;
+    for (auto &q : qs) {
+        vector<int> both, rest;
+        auto &x = sorted[q.allOf[0]], &y = sorted[q.allOf[1]], &z = sorted[q.noneOf[0]];
+        set_intersection(x.begin(), x.end(), y.begin(), y.end(), back_inserter(both));
+        set_difference(both.begin(), both.end(), z.begin(), z.end(), back_inserter(rest));
+        a += rest.size();
+    }
+    auto t1 = chrono::steady_clock::now();
+    size_t b = 0;
+    for (auto &q : qs) b += directory.query(q).size();
+    auto t2 = chrono::steady_clock::now();
+
+    cout << profileCount << " profiles, " << queries << " queries 'A AND B AND NOT C' over the 200 most popular skills\n";
+    cout << "  sorted vector<int> : " << 1e3 * ms(t1 - t0) / queries << " us/query, " << a << " results, "
+         << vectorBytes / (1 << 20) << " MiB of postings\n";
+    cout << "  PostingList        : " << 1e3 * ms(t2 - t1) / queries << " us/query, " << b << " results, "
+         << listBytes / (1 << 20) << " MiB of postings\n";
+}
+
 // Utility printing
 void printProfiles(const vector<Profile> &v) {
     for (const auto &p : v) {
@@ -175,7 +2316,51 @@ void printStrings(const vector<string> &v) {
     for (const auto &s : v) cout << s << "\n";
 }
 
-int main() {
+int main(int argc, char **argv) {
+    string indexPath; // --skill-index: demo directory index, reused across runs
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--skill-index" && i + 1 < argc) {
+            indexPath = argv[++i];
+        } else if (arg == "--bench-memory") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 1000000;
+            benchMemory(count, 200000);
+            return 0;
+        } else if (arg == "--bench-topk") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 200000;
+            benchTopK(count, 200000, 5);
+            return 0;
+        } else if (arg == "--bench-fuzzy") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 200000;
+            benchFuzzy(count, 200000, 200);
+            return 0;
+        } else if (arg == "--bench-concurrent") {
+            int readers = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : (int)max(1u, thread::hardware_concurrency());
+            benchConcurrent(400000, 100000, readers);
+            return 0;
+        } else if (arg == "--bench-query") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 1000000;
+            benchQuery(count, 200000, 2000);
+            return 0;
+        } else if (arg == "--bench-image") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 1000000;
+            benchImage(count, 200000, "skill-trie.img");
+            return 0;
+        } else if (arg == "--bench-bulk") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 1000000;
+            benchBulk(count, 200000);
+            return 0;
+        } else if (arg == "--bench-visit") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 1000000;
+            benchVisit(count, 200000);
+            return 0;
+        } else if (arg == "--bench-paging") {
+            int count = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? stoi(argv[++i]) : 1000000;
+            benchPaging(count, 200000, 20);
+            return 0;
+        }
+    }
+
     SkillDirectory directory;
 
     vector<Profile> inputs = {
@@ -197,13 +2382,45 @@ int main() {
     auto prefixes = directory.suggestions("py");
     printStrings(prefixes);
 
+    cout << "\n--- Skills Starting With 'p': " << directory.countSkills("p") << ", page 2 of size 2 ---\n";
+    printStrings(directory.suggestions("p", 2, 2));
+
+    cout << "\n--- Top 3 Suggestions For 'p' ---\n";
+    for (auto &s : directory.topSuggestions("p", 3)) cout << s.skill << " (" << s.popularity << ")\n";
+
     cout << "\n--- Profiles With Skill 'python' ---\n";
     auto pythonUsers = directory.profilesWithSkill("python");
     printProfiles(pythonUsers);
 
+    cout << "\n--- Fuzzy Search 'pyhton', 'javscript' ---\n";
+    for (string typed : { "pyhton", "javscript" }) {
+        for (auto &m : directory.fuzzySkills(typed)) {
+            cout << typed << " ~ " << m.skill << " (distance " << m.distance << ") profiles:";
+            for (int id : m.profiles) cout << " " << id;
+            cout << "\n";
+        }
+    }
+
+    cout << "\n--- Query 'python AND NOT django' ---\n";
+    for (int id : directory.query("python AND NOT django")) cout << directory.profile(id)->name << "\n";
+
     cout << "\n--- Contains Skill 'redux'? ---\n";
     cout << (directory.hasSkill("redux") ? "Yes\n" : "No\n");
 
+    if (!indexPath.empty()) {
+        SkillDirectory restarted;
+        bool reused = restarted.openSkillIndex(indexPath);
+        if (!reused && !(directory.saveSkillIndex(indexPath) && restarted.openSkillIndex(indexPath))) {
+            cerr << "Cannot write skill index " << indexPath << "\n";
+            return 1;
+        }
+        cout << "\n--- Directory Started From " << (reused ? "Existing" : "New") << " Skill Index ---\n";
+        printStrings(restarted.suggestions("py"));
+        cout << "profiles with 'python':";
+        for (int id : restarted.profileIdsWithSkill("python")) cout << " " << id;
+        cout << "\n";
+    }
+
     cout << "\n--- Running Skill-Stream Simulator ---\n";
     vector<Profile> newData = {
         {11, "Riya", {"rust", "rocket"}},
@@ -219,5 +2436,22 @@ int main() {
     auto rustUsers = directory.profilesWithSkill("rust");
     printProfiles(rustUsers);
 
+    cout << "\n--- Concurrent Directory: Reader Thread While Streaming ---\n";
+    ConcurrentSkillDirectory live;
+    for (auto &p : inputs) live.addProfile(p);
+    thread reader([&]() {
+        while (!live.hasSkill("rust")) this_thread::yield(); // lock-free snapshot per poll
+    });
+    SkillStreamSimulator liveSimulator(live, newData);
+    liveSimulator.streamUpdates(10, 4);
+    reader.join();
+    auto view = live.snapshot();
+    cout << "'py' suggestions:";
+    for (auto &s : view.skillsWithPrefix("py")) cout << " " << s;
+    cout << "\nprofiles with 'python':";
+    for (int id : view.profileMatches("python")) cout << " " << id;
+    cout << "\n";
+    printProfiles(live.profilesWithSkill("rust"));
+
     return 0;
 }